@@ -1,17 +1,51 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
 
-struct SegmentSample {
-	double translation[3];
-	double rotation_quat[4];
-	double velocity[3];
-};
+// One actor's pose, every segment a source can send in one fixed block that copies like plain memory.
+// Each component is an array over the segments (SoA) of float, the precision MVN sends, and every
+// array starts on its own cache line. Only segments with their bit in valid hold a pose.
+struct alignas(64) PoseSample {
+	// 23 body, 4 prop and 40 finger segments, padded so each component array is whole cache lines
+	static constexpr int Capacity = 80;
+
+	int32_t pose_id = 0;
+
+	// When the newest packet contributing to this pose arrived, in ns since the system_clock epoch, 0 if unknown
+	uint64_t receive_time_ns = 0;
+
+	uint64_t valid[(Capacity + 63) / 64] = {};
+
+	alignas(64) float translation[3][Capacity] = {};
+	alignas(64) float rotation_quat[4][Capacity] = {};	// w, x, y, z
+	alignas(64) float velocity[3][Capacity] = {};
+
+	bool IsValid(int segment) const {
+		return segment >= 0 && segment < Capacity && (valid[segment / 64] >> (segment % 64)) & 1;
+	}
+
+	void SetValid(int segment) {
+		valid[segment / 64] |= uint64_t(1) << (segment % 64);
+	}
+
+	// Take one segment, validity included, from another pose
+	void CopySegment(const PoseSample& from, int segment) {
+		for (int i = 0; i < 3; ++i)
+			translation[i][segment] = from.translation[i][segment];
+		for (int i = 0; i < 4; ++i)
+			rotation_quat[i][segment] = from.rotation_quat[i][segment];
+		for (int i = 0; i < 3; ++i)
+			velocity[i][segment] = from.velocity[i][segment];
 
-struct PoseSample {
-	int32_t pose_id;
-	std::vector<SegmentSample> segments;
+		uint64_t bit = uint64_t(1) << (segment % 64);
+		valid[segment / 64] = (valid[segment / 64] & ~bit) | (from.valid[segment / 64] & bit);
+	}
 };
+static_assert(std::is_trivially_copyable<PoseSample>::value, "PoseSample is copied with memcpy");
 
 // Forwards 
 namespace MocapDriver {
@@ -24,6 +58,37 @@ public:
 	virtual std::string GetRenderModelPath(int segmentIndex) = 0;
 	virtual void PopulateTrackers() = 0;
 	virtual MocapDriver::IVRDriver* GetDriver() = 0;
-	virtual void QueuePose(const PoseSample& pose) = 0;
-	virtual PoseSample GetNextPose() = 0;
-};
\ No newline at end of file
+	virtual void QueuePose(const PoseSample& pose, int actorIndex) = 0;
+	virtual int GetActorCount() = 0;
+
+	// Copy the latest pose of an actor into pose, false if there is none yet. Called every frame,
+	// so it must not block on the thread receiving poses.
+	virtual bool GetNextPose(int actorIndex, PoseSample& pose) = 0;
+};
+
+// Every actor's pose of one source as it was at the start of a driver frame.
+// Taken once per frame by RunFrame and only read by the devices after that, so all trackers of an
+// actor show the same sample however far the source moves on meanwhile. Each actor keeps the
+// sample counter and receive time of the pose it holds. Taking it again reuses every buffer.
+class PoseSnapshot {
+public:
+	void Capture(IMocapStreamSource& source) {
+		actors_.resize(source.GetActorCount());
+		for (int actor = 0; actor < (int)actors_.size(); ++actor)
+			actors_[actor].valid = source.GetNextPose(actor, actors_[actor].pose);
+	}
+
+	// The actor's pose, nullptr if the source had none for it
+	const PoseSample* GetPose(int actorIndex) const {
+		if (actorIndex < 0 || actorIndex >= (int)actors_.size() || !actors_[actorIndex].valid)
+			return nullptr;
+		return &actors_[actorIndex].pose;
+	}
+
+private:
+	struct Actor {
+		PoseSample pose{};
+		bool valid = false;
+	};
+	std::vector<Actor> actors_;
+};
@@ -33,6 +33,12 @@ namespace MocapDriver {
         /// </summary>
         /// <returns>Mocap segment index</returns>
         virtual int GetSegmentIndex() = 0;
+
+        /// <summary>
+        /// Returns the actor of a mocap source this tracker belongs to
+        /// </summary>
+        /// <returns>Mocap actor index</returns>
+        virtual int GetActorIndex() = 0;
         
         /// <summary>
         /// Returns which type of device this device is
@@ -57,6 +63,11 @@ namespace MocapDriver {
        /// </summary>
         virtual void SetSegmentIndex(int segmentIndex) = 0;
 
+        /// <summary>
+        /// Sets the actor of a mocap source this tracker belongs to
+        /// </summary>
+        virtual void SetActorIndex(int actorIndex) = 0;
+
         
         /// <summary>
         /// Makes a default device pose 
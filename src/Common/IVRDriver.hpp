@@ -5,6 +5,7 @@
 #include <variant>
 
 #include "IVRDevice.hpp"
+#include "LatencyHistogram.hpp"
 
 namespace MocapDriver {
 
@@ -24,7 +25,7 @@ namespace MocapDriver {
         /// <returns>All managed devices</returns>
         virtual std::vector<std::shared_ptr<IVRDevice>> GetDevices() = 0;
 
-        virtual std::shared_ptr<IVRDevice> CreateTrackerDevice(std::string serial, std::string role, IMocapStreamSource* motionSource = nullptr, int segmentIndex = -1) = 0;
+        virtual std::shared_ptr<IVRDevice> CreateTrackerDevice(std::string serial, std::string role, IMocapStreamSource* motionSource = nullptr, int segmentIndex = -1, int actorIndex = 0) = 0;
 
         /// <summary>
         /// Returns all OpenVR events that happened on the current frame
@@ -32,6 +33,14 @@ namespace MocapDriver {
         /// <returns>Current frame's OpenVR events</returns>
         virtual std::vector<vr::VREvent_t> GetOpenVREvents() = 0;
 
+        /// <summary>
+        /// Returns an actor's pose from the snapshot of its source taken for the current frame
+        /// </summary>
+        /// <param name="source">Mocap source the actor belongs to</param>
+        /// <param name="actorIndex">Actor of that source</param>
+        /// <returns>The actor's pose for this frame, nullptr if the source has none</returns>
+        virtual const PoseSample* GetFramePose(IMocapStreamSource* source, int actorIndex) = 0;
+
         /// <summary>
         /// Returns the milliseconds between last frame and this frame
         /// </summary>
@@ -76,6 +85,13 @@ namespace MocapDriver {
         /// <returns>OpenVR VRServerDriverHost pointer</returns>
         virtual vr::IVRServerDriverHost* GetDriverHost() = 0;
 
+        /// <summary>
+        /// Records how long a pose took from packet arrival until it was handed to OpenVR.
+        /// Only called from device updates, on the RunFrame thread
+        /// </summary>
+        /// <param name="latency">Arrival to TrackedDevicePoseUpdated</param>
+        virtual void RecordPoseLatency(std::chrono::nanoseconds latency) = 0;
+
         /// <summary>
         /// Writes a log message
         /// </summary>
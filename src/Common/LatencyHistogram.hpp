@@ -0,0 +1,93 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+// Log-linear histogram of latencies with microsecond resolution.
+// Every power of two is split into SubBuckets equal steps, so any recorded value is
+// reported within 1/SubBuckets (12.5%) of its true value, from 1 us up to ~17 minutes.
+// Recording is a handful of integer ops and never allocates, so it can sit on the frame path.
+class LatencyHistogram {
+public:
+    static constexpr int SubBuckets = 8;
+    static constexpr int BucketCount = 256;
+
+    void Record(std::chrono::nanoseconds latency) {
+        uint64_t us = latency.count() > 0 ? (uint64_t)latency.count() / 1000 : 0;
+        buckets_[BucketIndex(us)]++;
+        count_++;
+        sum_us_ += us;
+        if (us > max_us_)
+            max_us_ = us;
+    }
+
+    void Reset() {
+        buckets_.fill(0);
+        count_ = 0;
+        sum_us_ = 0;
+        max_us_ = 0;
+    }
+
+    uint64_t Count() const { return count_; }
+
+    // Upper bound of the bucket holding the given fraction of samples, in microseconds
+    uint64_t Percentile(double fraction) const {
+        if (!count_)
+            return 0;
+        uint64_t target = (uint64_t)(fraction * (double)(count_ - 1)) + 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < BucketCount; ++i) {
+            seen += buckets_[i];
+            if (seen >= target)
+                return std::min(BucketLowerBound(i + 1) - 1, max_us_);
+        }
+        return max_us_;
+    }
+
+    // One line summary for the driver log, e.g. "n=1440 mean=2.31ms p50=2.11ms p99=5.63ms max=7.02ms"
+    std::string Summary() const {
+        std::ostringstream out;
+        out.setf(std::ios::fixed);
+        out.precision(2);
+        out << "n=" << count_
+            << " mean=" << (count_ ? (double)sum_us_ / count_ / 1000.0 : 0.0) << "ms"
+            << " p50=" << Percentile(0.5) / 1000.0 << "ms"
+            << " p90=" << Percentile(0.9) / 1000.0 << "ms"
+            << " p99=" << Percentile(0.99) / 1000.0 << "ms"
+            << " p99.9=" << Percentile(0.999) / 1000.0 << "ms"
+            << " max=" << max_us_ / 1000.0 << "ms";
+        return out.str();
+    }
+
+private:
+    static int BucketIndex(uint64_t us) {
+        if (us < SubBuckets)
+            return (int)us;
+        int exponent = 63 - CountLeadingZeros(us);
+        int index = (exponent - 2) * SubBuckets + (int)((us >> (exponent - 3)) & (SubBuckets - 1));
+        return index < BucketCount ? index : BucketCount - 1;
+    }
+
+    static uint64_t BucketLowerBound(int index) {
+        if (index < SubBuckets)
+            return (uint64_t)index;
+        int exponent = index / SubBuckets + 2;
+        return (uint64_t)(SubBuckets + index % SubBuckets) << (exponent - 3);
+    }
+
+    static int CountLeadingZeros(uint64_t value) {
+        int zeros = 0;
+        for (uint64_t bit = 1ull << 63; bit && !(value & bit); bit >>= 1)
+            ++zeros;
+        return zeros;
+    }
+
+    std::array<uint64_t, BucketCount> buckets_ = {};
+    uint64_t count_ = 0;
+    uint64_t sum_us_ = 0;
+    uint64_t max_us_ = 0;
+};
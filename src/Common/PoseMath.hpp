@@ -57,12 +57,40 @@ inline linalg::mat<float, 4, 4> GetTransformMatrixFromVector(linalg::vec<float,
 // -----------------
 
 inline linalg::mat<float, 4, 4> ConvertZtoYUp(linalg::mat<float, 4, 4> inMatrix) {
-    linalg::mat<float, 4, 4> ZtoYupMatrix(
+    static const linalg::mat<float, 4, 4> ZtoYupMatrix(
         linalg::vec<float, 4>(0, 0, 1, 0),
         linalg::vec<float, 4>(1, 0, 0, 0),
         linalg::vec<float, 4>(0, 1, 0, 0),
         linalg::vec<float, 4>(0, 0, 0, 1)
     );
-    return linalg::mul(linalg::mul(ZtoYupMatrix, inMatrix), linalg::inverse(ZtoYupMatrix));
+
+    // A permutation, so its inverse is its transpose
+    return linalg::mul(linalg::mul(ZtoYupMatrix, inMatrix), linalg::transpose(ZtoYupMatrix));
+}
+
+// The change of basis above only cycles the axes, (x, y, z) becomes (y, z, x). Positions and
+// velocities are converted by reordering their components, and so is the vector part of a
+// quaternion, which gives the same rotation as converting its matrix. Quaternions are linalg's
+// (x, y, z, w).
+template<class T>
+constexpr linalg::vec<T, 3> ConvertZtoYUp(const linalg::vec<T, 3>& inVec) {
+    return { inVec.y, inVec.z, inVec.x };
+}
+
+template<class T>
+constexpr linalg::vec<T, 4> ConvertZtoYUpQuat(const linalg::vec<T, 4>& inQuat) {
+    return { inQuat.y, inQuat.z, inQuat.x, inQuat.w };
+}
+
+// Unity3D is Y-up like OpenVR but left-handed, so only x is mirrored. A mirror flips the sense of
+// rotation, so the quaternion keeps its x and negates y and z.
+template<class T>
+constexpr linalg::vec<T, 3> ConvertUnityToYUp(const linalg::vec<T, 3>& inVec) {
+    return { -inVec.x, inVec.y, inVec.z };
+}
+
+template<class T>
+constexpr linalg::vec<T, 4> ConvertUnityToYUpQuat(const linalg::vec<T, 4>& inQuat) {
+    return { inQuat.x, -inQuat.y, -inQuat.z, inQuat.w };
 }
 
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+#include "IMocapStreamSource.hpp"
+
+// The latest pose of one actor, handed from the thread that receives it to the threads that read it.
+// A seqlock: the writer makes the sequence odd, updates the pose in place and makes it even again.
+// A reader copies the pose and starts over if the sequence moved meanwhile, so readers never block
+// the writer and the writer never waits for a reader. Writers must not overlap each other.
+class PosePublisher {
+public:
+    // The pose to update in place, readers see none of it until EndWrite()
+    PoseSample& BeginWrite() {
+        sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        return pose_;
+    }
+
+    void EndWrite() {
+        sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Replace the whole pose
+    void Publish(const PoseSample& pose) {
+        std::memcpy(&BeginWrite(), &pose, sizeof(PoseSample));
+        EndWrite();
+    }
+
+    // Copy the latest pose into pose, false if nothing has been published yet
+    bool Read(PoseSample& pose) const {
+        for (;;) {
+            uint32_t before = sequence_.load(std::memory_order_acquire);
+            if (before & 1) {
+                // The writer is mid-update, or was preempted there
+                std::this_thread::yield();
+                continue;
+            }
+
+            // This copy races with the writer by design, it is thrown away if the writer got in
+            std::memcpy(&pose, &pose_, sizeof(PoseSample));
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == before)
+                return before != 0;
+        }
+    }
+
+private:
+    std::atomic<uint32_t> sequence_{ 0 };
+    PoseSample pose_{};
+};
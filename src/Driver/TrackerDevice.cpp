@@ -9,7 +9,8 @@ TrackerDevice::TrackerDevice(std::string serial, std::string role):
     motionSource_(nullptr),
     _pose_timestamp(0),
     rotation_origin(),
-    segmentIndex_(-1)
+    segmentIndex_(-1),
+    actorIndex_(0)
 {
     this->last_pose_ = MakeDefaultPose();
     this->isSetup = false;
@@ -66,6 +67,16 @@ int MocapDriver::TrackerDevice::GetSegmentIndex()
     return segmentIndex_;
 }
 
+void MocapDriver::TrackerDevice::SetActorIndex(int actorIndex)
+{
+    actorIndex_ = actorIndex;
+}
+
+int MocapDriver::TrackerDevice::GetActorIndex()
+{
+    return actorIndex_;
+}
+
 IMocapStreamSource* MocapDriver::TrackerDevice::GetMotionSource()
 {
     return motionSource_;
@@ -110,22 +121,31 @@ void TrackerDevice::Update()
     _pose_timestamp = time_since_epoch;
 
     // Get motion source
+    uint64_t pose_receive_time_ns = 0;
     auto source = GetMotionSource();
     if (source) {
-        auto pose = source->GetNextPose();
+        // RunFrame snapshots each source once for all devices, so every tracker of an actor shows the same sample
+        const PoseSample* frame_pose = GetDriver()->GetFramePose(source, GetActorIndex());
         auto segmentIndex = GetSegmentIndex();
-        if (segmentIndex < 0 || !pose.segments.size()) {
+        if (!frame_pose || !frame_pose->IsValid(segmentIndex)) {
             return;
         }
+        const PoseSample& pose = *frame_pose;
+
+        // The same pose is resubmitted until a newer one arrives, only its first submission is a latency sample
+        if (pose.pose_id != last_pose_id_) {
+            pose_receive_time_ns = pose.receive_time_ns;
+            last_pose_id_ = pose.pose_id;
+        }
 
-        tracker_pose.vecPosition[0] = pose.segments[segmentIndex].translation[0];
-        tracker_pose.vecPosition[1] = pose.segments[segmentIndex].translation[1];
-        tracker_pose.vecPosition[2] = pose.segments[segmentIndex].translation[2];
+        tracker_pose.vecPosition[0] = pose.translation[0][segmentIndex];
+        tracker_pose.vecPosition[1] = pose.translation[1][segmentIndex];
+        tracker_pose.vecPosition[2] = pose.translation[2][segmentIndex];
 
-        tracker_pose.qRotation.w = pose.segments[segmentIndex].rotation_quat[0];
-        tracker_pose.qRotation.x = pose.segments[segmentIndex].rotation_quat[1];
-        tracker_pose.qRotation.y = pose.segments[segmentIndex].rotation_quat[2];
-        tracker_pose.qRotation.z = pose.segments[segmentIndex].rotation_quat[3];
+        tracker_pose.qRotation.w = pose.rotation_quat[0][segmentIndex];
+        tracker_pose.qRotation.x = pose.rotation_quat[1][segmentIndex];
+        tracker_pose.qRotation.y = pose.rotation_quat[2][segmentIndex];
+        tracker_pose.qRotation.z = pose.rotation_quat[3][segmentIndex];
 
 
         // Set world origin from universe standing position
@@ -206,6 +226,12 @@ void TrackerDevice::Update()
     // Post pose
     GetDriver()->GetDriverHost()->TrackedDevicePoseUpdated(this->device_index_, tracker_pose, sizeof(vr::DriverPose_t));
     this->last_pose_ = tracker_pose;
+
+    // Same clock the receiver stamps packets with
+    if (pose_receive_time_ns) {
+        auto submitted = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch());
+        GetDriver()->RecordPoseLatency(submitted - std::chrono::nanoseconds(pose_receive_time_ns));
+    }
 }
 
 void TrackerDevice::Log(std::string message)
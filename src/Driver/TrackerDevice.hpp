@@ -40,6 +40,8 @@ namespace MocapDriver {
             virtual void SetMotionSource(IMocapStreamSource* motionSource);
             virtual void SetSegmentIndex(int segmentIndex) override;
             virtual int GetSegmentIndex() override;
+            virtual void SetActorIndex(int actorIndex) override;
+            virtual int GetActorIndex() override;
             virtual IMocapStreamSource* GetMotionSource();
     private:
         vr::TrackedDeviceIndex_t device_index_ = vr::k_unTrackedDeviceIndexInvalid;
@@ -67,6 +69,8 @@ namespace MocapDriver {
 
         IMocapStreamSource* motionSource_;
         int segmentIndex_;
+        int actorIndex_;
+        int32_t last_pose_id_ = -1;
         double translation_origin[3] = {};
         vr::HmdQuaternion_t rotation_origin;
     };
@@ -91,9 +91,20 @@ void VRDriver::RunFrame()
     this->frame_timing_avg_ = this->frame_timing_avg_ * 0.9 + ((double)this->frame_timing_.count()) * 0.1;
     //MessageBox(NULL, std::to_string(((double)this->frame_timing_.count()) * 0.1).c_str(), "Example Driver", MB_OK);
 
+    // Sources are read once per frame rather than once per tracker, and a whole skeleton comes from one sample
+    this->frame_poses_.resize(this->streamSources_.size());
+    for (size_t i = 0; i < this->streamSources_.size(); ++i)
+        this->frame_poses_[i].Capture(*this->streamSources_[i]);
+
     for (auto& device : this->devices_)
         device->Update();
 
+    if (now - this->last_latency_report_ >= this->latency_report_interval_) {
+        if (this->pose_latency_.Count())
+            Log("Pose latency (packet arrival to submission): " + this->pose_latency_.Summary());
+        this->pose_latency_.Reset();
+        this->last_latency_report_ = now;
+    }
 }
 
 bool VRDriver::ShouldBlockStandbyMode()
@@ -119,16 +130,26 @@ std::vector<vr::VREvent_t> VRDriver::GetOpenVREvents()
     return this->openvr_events_;
 }
 
+const PoseSample* VRDriver::GetFramePose(IMocapStreamSource* source, int actorIndex)
+{
+    for (size_t i = 0; i < this->streamSources_.size() && i < this->frame_poses_.size(); ++i) {
+        if (this->streamSources_[i].get() == source)
+            return this->frame_poses_[i].GetPose(actorIndex);
+    }
+    return nullptr;
+}
+
 std::chrono::milliseconds VRDriver::GetLastFrameTime()
 {
     return this->frame_timing_;
 }
 
-std::shared_ptr<IVRDevice> MocapDriver::VRDriver::CreateTrackerDevice(std::string serial, std::string role, IMocapStreamSource* motionSource, int segmentIndex)
+std::shared_ptr<IVRDevice> MocapDriver::VRDriver::CreateTrackerDevice(std::string serial, std::string role, IMocapStreamSource* motionSource, int segmentIndex, int actorIndex)
 {
     auto addtracker = std::make_shared<TrackerDevice>(serial, role);
     addtracker->SetMotionSource(motionSource);
     addtracker->SetSegmentIndex(segmentIndex);
+    addtracker->SetActorIndex(actorIndex);
 
     AddDevice(addtracker);
     addtracker->reinit(tracker_max_saved, tracker_max_time, tracker_smoothing, origin_);
@@ -199,6 +220,11 @@ void VRDriver::Log(std::string message)
     vr::VRDriverLog()->Log(message_endl.c_str());
 }
 
+void VRDriver::RecordPoseLatency(std::chrono::nanoseconds latency)
+{
+    this->pose_latency_.Record(latency);
+}
+
 UniverseOrigin MocapDriver::VRDriver::GetUniverseOrigin()
 {
     return origin_;
@@ -21,11 +21,13 @@ namespace MocapDriver {
         // Inherited via IVRDriver
         virtual std::vector<std::shared_ptr<IVRDevice>> GetDevices() override;
         virtual std::vector<vr::VREvent_t> GetOpenVREvents() override;
+        virtual const PoseSample* GetFramePose(IMocapStreamSource* source, int actorIndex) override;
         virtual std::chrono::milliseconds GetLastFrameTime() override;
-        virtual std::shared_ptr<IVRDevice> CreateTrackerDevice(std::string serial, std::string role, IMocapStreamSource* motionSource, int segmentIndex) override;
+        virtual std::shared_ptr<IVRDevice> CreateTrackerDevice(std::string serial, std::string role, IMocapStreamSource* motionSource, int segmentIndex, int actorIndex) override;
         virtual bool AddDevice(std::shared_ptr<IVRDevice> device) override;
         virtual SettingsValue GetSettingsValue(std::string key) override;
         virtual void Log(std::string message) override;
+        virtual void RecordPoseLatency(std::chrono::nanoseconds latency) override;
         virtual UniverseOrigin GetUniverseOrigin() override;
 
         virtual vr::IVRDriverInput* GetInput() override;
@@ -54,9 +56,17 @@ namespace MocapDriver {
         std::chrono::system_clock::time_point last_frame_time_ = std::chrono::system_clock::now();
         std::string settings_key_ = "Mocap";
 
+        // Packet arrival to pose submission, logged and reset every latency_report_interval_
+        LatencyHistogram pose_latency_;
+        std::chrono::seconds latency_report_interval_ = std::chrono::seconds(10);
+        std::chrono::system_clock::time_point last_latency_report_ = std::chrono::system_clock::now();
+
         // Mocap sources
         std::vector< std::unique_ptr<IMocapStreamSource> > streamSources_;
 
+        // One per stream source, taken at the start of RunFrame for every device to read
+        std::vector<PoseSnapshot> frame_poses_;
+
         vr::HmdQuaternion_t GetRotation(vr::HmdMatrix34_t matrix);
         vr::HmdVector3_t GetPosition(vr::HmdMatrix34_t matrix);
 
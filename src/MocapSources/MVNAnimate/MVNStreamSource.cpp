@@ -2,38 +2,130 @@
 
 #include "MVNStreamSource.h"
 #include "quaterniondatagram.h"
+#include "unity3ddatagram.h"
 #include <PoseMath.hpp>
 #include <linearsegmentkinematicsdatagram.h>
+#include <algorithm>
+
+// The protocols that make up a whole pose when RequireLinearKinematics holds poses back
+enum PosePart : uint32_t {
+    PosePart_Transform = 1,     // quaternion or Unity3D
+    PosePart_Velocity = 2,      // linear segment kinematics
+};
 
 void MVNStreamSource::init(MocapDriver::IVRDriver* owning_driver)
 {
 	driver_ = owning_driver;
 
+    // Pipelines exist before the server starts, so the receive thread never sees them change
+    int avatar_count = GetSettingsAvatarCount();
+    for (int avatar_id = 0; avatar_id < avatar_count; ++avatar_id) {
+        auto avatar = std::make_unique<AvatarPipeline>();
+        for (auto segment : SegmentName) {
+            if (GetSettingsSegmentTarget(segment.first, avatar_id).compare("disabled"))
+            {
+                avatar->segments.push_back(segment.first);
+                avatar->segment_ids.set(segment.first + 1);
+            }
+        }
+        avatars_.push_back(std::move(avatar));
+    }
+
+    // Without this a pose is published as its packets arrive, velocities lagging the transforms by a packet
+    require_linear_kinematics_ = GetSettingsBool("RequireLinearKinematics", false);
+    if (require_linear_kinematics_) {
+        for (auto& avatar : avatars_)
+            avatar->assembler.reset(PosePart_Transform | PosePart_Velocity);
+        GetDriver()->Log("MVN poses are published once both transforms and linear kinematics have arrived");
+    }
+
+    // Every decoded datagram goes straight to the handler for its type, see DatagramVisitor
+    DatagramCallback receive_cb = DatagramCallback::visitor(datagram_visitor_);
+    DatagramFilter filter = GetDatagramFilter();
+
+    // A recorded session stands in for the suit, looping with its original timing
+    std::string replay_path = GetSettingsString("ReplayPath");
+    if (!replay_path.empty()) {
+        mvn_replay_ = std::make_unique<PacketReplay>(receive_cb, filter);
+        if (mvn_replay_->open(replay_path)) {
+            mvn_replay_->startThread(PacketReplay::RealTime, true);
+            GetDriver()->Log("Replaying MVN capture " + replay_path);
+            return;
+        }
+        GetDriver()->Log("Failed to open MVN capture " + replay_path + ", listening to the network instead");
+        mvn_replay_.reset();
+    }
+
     int port = 9763;
     std::string hostDestinationAddress = "localhost";
+
+    // A multicast group lets a recorder or spectator PC share the one stream MVN sends
+    std::string multicast_group = GetSettingsString("MulticastGroup");
+    std::string multicast_interface = GetSettingsString("MulticastInterface");
+    if (!multicast_group.empty()) {
+        if (UdpReceiver::isMulticast(multicast_group)) {
+            hostDestinationAddress = multicast_group;
+            GetDriver()->Log("Joining MVN multicast group " + multicast_group
+                + (multicast_interface.empty() ? "" : " on " + multicast_interface));
+        }
+        else {
+            GetDriver()->Log("MVN/MulticastGroup " + multicast_group + " is not an IPv4 multicast address, listening for unicast");
+        }
+    }
+
     mvn_udp_server_ = std::make_unique<UdpServer>(
         hostDestinationAddress,
         (uint16_t)port,
-        [this](StreamingProtocol protocol, const Datagram* message) {
-            this->ReceiveMVNData(protocol, message);
-        });
-    GetDriver()->Log("Created MVN listen server");
+        receive_cb,
+        GetSettingsString("CapturePath"),
+        filter,
+        multicast_interface);
+
+    // Live VR wants the freshest pose, so an opt-in mode skips the backlog a stall leaves in the socket
+    if (GetSettingsBool("DrainToLatest", false)) {
+        mvn_udp_server_->setDrainToLatest(true);
+        GetDriver()->Log("MVN drain-to-latest enabled, stale samples are skipped after a stall");
+    }
+
+    // Machines with a spare core can trade it for tighter pose timing
+    ThreadScheduling scheduling;
+    scheduling.cpu = GetSettingsInt("ReceiveThreadCpu", -1);
+    scheduling.realtime = GetSettingsBool("ReceiveThreadRealtime", false);
+    if (!scheduling.isDefault())
+        GetDriver()->Log("MVN receive thread: " + mvn_udp_server_->setThreadScheduling(scheduling));
+
+    int spin_us = GetSettingsInt("ReceiveSpinUs", 0);
+    if (spin_us > 0) {
+        mvn_udp_server_->setSpin((uint32_t)spin_us);
+        GetDriver()->Log("MVN receive spins " + std::to_string(spin_us) + " us before blocking");
+    }
+
+    int busy_poll_us = GetSettingsInt("ReceiveBusyPollUs", 0);
+    if (busy_poll_us > 0) {
+        bool accepted = mvn_udp_server_->setBusyPoll((uint32_t)busy_poll_us);
+        GetDriver()->Log("MVN socket busy poll " + std::to_string(busy_poll_us) + " us " + (accepted ? "enabled" : "not permitted"));
+    }
+    GetDriver()->Log("Created MVN listen server for " + std::to_string(avatar_count) + " avatar(s)");
 }
 
 void MVNStreamSource::PopulateTrackers()
 {
-    for (auto segment : SegmentName) {
-        std::string segment_hint = GetSettingsSegmentTarget(segment.first);
-        if (segment_hint.compare("disabled")) {
-            std::string name = SegmentName.at(segment.first);
-            std::string role = segment.second;
+    for (int avatar_id = 0; avatar_id < (int)avatars_.size(); ++avatar_id) {
+        AvatarPipeline& avatar = *avatars_[avatar_id];
+
+        // The first avatar keeps the plain segment serials, so existing SteamVR role bindings still apply
+        std::string serial_prefix = avatar_id ? "Avatar" + std::to_string(avatar_id) + "_" : "";
 
-            auto tracker = GetDriver()->CreateTrackerDevice(name, role, this, segment.first);
+        for (auto segment : avatar.segments) {
+            std::string name = serial_prefix + SegmentName.at(segment);
+            std::string role = SegmentName.at(segment);
+
+            auto tracker = GetDriver()->CreateTrackerDevice(name, role, this, segment, avatar_id);
 
             std::string rendermodel = std::string("{Mocap}/rendermodels/XSens/") + tracker->GetSerial();
             GetDriver()->Log("Tracker rendermodel path: " + rendermodel);
 
-            trackers_.emplace(segment.first, tracker);
+            avatar.trackers.emplace(segment, tracker);
         }
     }
 }
@@ -43,16 +135,52 @@ MocapDriver::IVRDriver* MVNStreamSource::GetDriver()
     return driver_;
 }
 
-PoseSample MVNStreamSource::GetNextPose()
+bool MVNStreamSource::GetNextPose(int actorIndex, PoseSample& pose)
+{
+    if (actorIndex < 0 || actorIndex >= (int)avatars_.size())
+        return false;
+
+    return avatars_[actorIndex]->published_pose.Read(pose);
+}
+
+void MVNStreamSource::QueuePose(const PoseSample& pose, int actorIndex)
 {
-    std::scoped_lock<std::mutex> lock(pose_update_mtx);
-    return PoseSample(completed_pose_);
+    if (actorIndex < 0 || actorIndex >= (int)avatars_.size())
+        return;
+
+    AvatarPipeline& avatar = *avatars_[actorIndex];
+    std::scoped_lock<std::mutex> lock(avatar.pose_write_mtx);
+    avatar.published_pose.Publish(pose);
 }
 
-void MVNStreamSource::QueuePose(const PoseSample& pose)
+int MVNStreamSource::GetActorCount()
 {
-    std::scoped_lock<std::mutex> lock(pose_update_mtx);
-    completed_pose_ = pose;
+    return (int)avatars_.size();
+}
+
+DatagramFilter MVNStreamSource::GetDatagramFilter()
+{
+    DatagramFilter filter;
+
+    // Only what ReceiveMVNData consumes is decoded, everything else is dropped on its header
+    filter.protocols.reset();
+    filter.protocols.set(StreamingProtocol::SPMetaMoreMeta);
+    filter.protocols.set(StreamingProtocol::SPPoseQuaternion);
+    filter.protocols.set(StreamingProtocol::SPPoseUnity3D);
+    filter.protocols.set(StreamingProtocol::SPLinearSegmentKinematics);
+
+    // Pose records are converted straight from the packet, see ReceiveMVNData
+    filter.rawRecords.set(StreamingProtocol::SPPoseQuaternion);
+    filter.rawRecords.set(StreamingProtocol::SPPoseUnity3D);
+    filter.rawRecords.set(StreamingProtocol::SPLinearSegmentKinematics);
+
+    // Segment IDs are the same for every avatar, so the union of all mapped segments is decoded
+    for (auto& avatar : avatars_)
+        avatar->segment_ids.forEach([&filter](int32_t segment_id) { filter.segments.set(segment_id); });
+
+    // Datagrams are printed to stdout by default, which nobody reads inside vrserver
+    filter.print = false;
+    return filter;
 }
 
 std::string MVNStreamSource::GetRenderModelPath(int segmentIndex)
@@ -61,11 +189,22 @@ std::string MVNStreamSource::GetRenderModelPath(int segmentIndex)
     return std::string("XSens/") + SegmentName.at((Segment)segmentIndex); //"{htc}/rendermodels/vr_tracker_vive_1_0"; 
 }
 
-std::string MVNStreamSource::GetSettingsSegmentTarget(Segment segment)
+std::string MVNStreamSource::GetSettingsSegmentTarget(Segment segment, int avatarId)
 {
-    std::string prefix = "Role_";
-    std::string key = prefix + SegmentName.at(segment);
+    std::string key = std::string("Role_") + SegmentName.at(segment);
+
+    // Further avatars may override a role with Avatar<N>_Role_<Segment> and otherwise share the first avatar's roles
+    if (avatarId > 0) {
+        std::string str_value = GetSettingsString("Avatar" + std::to_string(avatarId) + "_" + key);
+        if (!str_value.empty())
+            return str_value;
+    }
+
+    return GetSettingsString(key);
+}
 
+std::string MVNStreamSource::GetSettingsString(const std::string& key)
+{
     vr::EVRSettingsError err = vr::EVRSettingsError::VRSettingsError_None;
     char* buf = (char*)malloc(sizeof(char) * 1024);
     vr::VRSettings()->GetString("MVN", key.c_str(), buf, 1024, &err);
@@ -79,77 +218,192 @@ std::string MVNStreamSource::GetSettingsSegmentTarget(Segment segment)
     return "";
 }
 
-void MVNStreamSource::ReceiveMVNData(StreamingProtocol protocol, const Datagram* message)
-{
-    int32_t msg_id = message->sampleCounter();
-    bool pose_is_complete = true;
-
-    // Create a new pose if it isn't already being filled
-    if (incomplete_poses_.find(msg_id) == incomplete_poses_.end()) {
-        incomplete_poses_.emplace(msg_id, PoseSample{ msg_id, std::vector<SegmentSample>(SegmentName.size()) });
-        
-#ifdef MVN_SUPPORTS_LINEAR_KINEMATICS 
-        pose_is_complete = false;
-#endif
-    } 
-
-    for (auto tracker_pair : trackers_) {
-        auto segment = tracker_pair.first;
-
-        // Find incomplete pose segment for us to fill
-        auto segment_it = incomplete_poses_[msg_id].segments.begin() + segment;
-    
-        if (protocol == StreamingProtocol::SPPoseQuaternion) {
-            const QuaternionDatagram* quat_msg = static_cast<const QuaternionDatagram*>(message);
-            auto segment_data = quat_msg->GetSegmentData(segment);
-            
-            if (segment_data.segmentId > -1){
-                // Parse MVN formatted data into a matrix to perform coordinate system conversions
-                linalg::vec <float, 4> segment_quat(segment_data.orientation[1], segment_data.orientation[2], segment_data.orientation[3], segment_data.orientation[0]);
-                linalg::vec <float, 4> segment_quat_normalized = linalg::normalize(segment_quat);
-                auto transformMatrix = linalg::pose_matrix(
-                    segment_quat_normalized,
-                    linalg::vec<float, 3>(segment_data.position[0], segment_data.position[1], segment_data.position[2])
-                );
-
-                // Convert MVN Animate Z-up to OpenVR Y-up
-                linalg::mat<float, 4, 4> vrMatrix = ConvertZtoYUp(transformMatrix);
-
-                // Pull quaternion out of segment transformation matrix
-                linalg::vec<float, 4> rotQuat = linalg::rotation_quat(GetRotationMatrixFromTransform(vrMatrix));
-
-                segment_it->translation[0] = vrMatrix.w.x;
-                segment_it->translation[1] = vrMatrix.w.y;
-                segment_it->translation[2] = vrMatrix.w.z;
-                segment_it->rotation_quat[0] = rotQuat.w;
-                segment_it->rotation_quat[1] = rotQuat.x;
-                segment_it->rotation_quat[2] = rotQuat.y;
-                segment_it->rotation_quat[3] = rotQuat.z;
-            }
-        }
-        else if (protocol == StreamingProtocol::SPLinearSegmentKinematics) {
-            const LinearSegmentKinematicsDatagram* linear_kinematics_msg = static_cast<const LinearSegmentKinematicsDatagram*>(message);
-            auto segment_data = linear_kinematics_msg->GetSegmentData(segment);
-            
-            if (segment_data.segmentId > -1) {
-                auto velocity_matrix = GetTransformMatrixFromVector(
-                    linalg::vec<float, 3>{segment_data.velocity[0], segment_data.velocity[1], segment_data.velocity[2]},
-                    linalg::vec<float, 3>{0.0, 0.0, 1.0}
-                );
-
-                // Convert MVN Animate Z-up to OpenVR Y-up
-                linalg::mat<float, 4, 4> vrMatrix = ConvertZtoYUp(velocity_matrix);
-
-                segment_it->velocity[0] = vrMatrix.x.z;
-                segment_it->velocity[1] = vrMatrix.y.z;
-                segment_it->velocity[2] = vrMatrix.z.z;
-            }
-        }
+int MVNStreamSource::GetSettingsInt(const std::string& key, int fallback)
+{
+    vr::EVRSettingsError err = vr::EVRSettingsError::VRSettingsError_None;
+    int value = vr::VRSettings()->GetInt32("MVN", key.c_str(), &err);
+    return err == vr::EVRSettingsError::VRSettingsError_None ? value : fallback;
+}
+
+bool MVNStreamSource::GetSettingsBool(const std::string& key, bool fallback)
+{
+    vr::EVRSettingsError err = vr::EVRSettingsError::VRSettingsError_None;
+    bool value = vr::VRSettings()->GetBool("MVN", key.c_str(), &err);
+    return err == vr::EVRSettingsError::VRSettingsError_None ? value : fallback;
+}
+
+int MVNStreamSource::GetSettingsAvatarCount()
+{
+    vr::EVRSettingsError err = vr::EVRSettingsError::VRSettingsError_None;
+    int count = vr::VRSettings()->GetInt32("MVN", "AvatarCount", &err);
+
+    if (err != vr::EVRSettingsError::VRSettingsError_None || count < 1) {
+        return 1;
+    }
+
+    // Avatar IDs are a single byte in the datagram header
+    return std::min(count, 256);
+}
+
+MVNStreamSource::AvatarPipeline* MVNStreamSource::GetAvatar(const Datagram& message)
+{
+    int avatar_id = message.avatarId();
+    if (avatar_id < (int)avatars_.size())
+        return avatars_[avatar_id].get();
+
+    if (!unknown_avatars_.test(avatar_id)) {
+        unknown_avatars_.set(avatar_id);
+        GetDriver()->Log("Ignoring MVN avatar " + std::to_string(avatar_id) + ", raise MVN/AvatarCount to track it");
+    }
+    return nullptr;
+}
+
+void MVNStreamSource::ReceiveMVNMetaData(const MetaDatagram& message)
+{
+    AvatarPipeline* avatar = GetAvatar(message);
+    if (!avatar)
+        return;
+
+    // MVN repeats the same string about once a second, only a changed one is parsed
+    if (message.content() == avatar->meta_content)
+        return;
+    avatar->meta_content.assign(message.content().data(), message.content().size());
+
+    std::string name = message.itemData("name");
+    std::string color = message.itemData("color");
+    std::string xmid = message.itemData("xmid");
+
+    if (name == avatar->name && color == avatar->color && xmid == avatar->xmid)
+        return;
+
+    avatar->name = name;
+    avatar->color = color;
+    avatar->xmid = xmid;
+    GetDriver()->Log("MVN avatar " + std::to_string(message.avatarId()) + " is " + name + " (color #" + color + ", xmid " + xmid + ")");
+}
+
+// Convert one wire record into the part of a pose segment its protocol carries, overloaded per
+// datagram type so the pose kernel below is compiled once per protocol
+
+static void SetSegmentTransform(PoseSample& pose, int segment, const linalg::vec<float, 3>& translation, const linalg::vec<float, 4>& rotation)
+{
+    pose.translation[0][segment] = translation.x;
+    pose.translation[1][segment] = translation.y;
+    pose.translation[2][segment] = translation.z;
+    pose.rotation_quat[0][segment] = rotation.w;
+    pose.rotation_quat[1][segment] = rotation.x;
+    pose.rotation_quat[2][segment] = rotation.y;
+    pose.rotation_quat[3][segment] = rotation.z;
+    pose.SetValid(segment);
+}
+
+static void ApplySegmentData(const QuaternionDatagram&, const float* fields, PoseSample& pose, int segment)
+{
+    // MVN sends the real part of the quaternion first
+    linalg::vec<float, 4> rotation{ fields[4], fields[5], fields[6], fields[3] };
+    float norm = linalg::length(rotation);
+    if (norm <= 0.0f)
+        return;
+
+    SetSegmentTransform(pose, segment,
+        ConvertZtoYUp(linalg::vec<float, 3>{ fields[0], fields[1], fields[2] }),
+        ConvertZtoYUpQuat(rotation / norm));
+}
+
+static void ApplySegmentData(const Unity3DDatagram&, const float* fields, PoseSample& pose, int segment)
+{
+    // Same layout as the quaternion protocol, real part first
+    linalg::vec<float, 4> rotation{ fields[4], fields[5], fields[6], fields[3] };
+    float norm = linalg::length(rotation);
+    if (norm <= 0.0f)
+        return;
+
+    SetSegmentTransform(pose, segment,
+        ConvertUnityToYUp(linalg::vec<float, 3>{ fields[0], fields[1], fields[2] }),
+        ConvertUnityToYUpQuat(rotation / norm));
+}
+
+// Velocities alone do not make a segment valid, a pose needs its transform
+static void ApplySegmentData(const LinearSegmentKinematicsDatagram&, const float* fields, PoseSample& pose, int segment)
+{
+    // A velocity is a free vector, so it changes basis like a position
+    linalg::vec<float, 3> velocity = ConvertZtoYUp(linalg::vec<float, 3>{ fields[3], fields[4], fields[5] });
+    pose.velocity[0][segment] = velocity.x;
+    pose.velocity[1][segment] = velocity.y;
+    pose.velocity[2][segment] = velocity.z;
+}
+
+static uint32_t GetPosePart(const QuaternionDatagram&) { return PosePart_Transform; }
+static uint32_t GetPosePart(const Unity3DDatagram&) { return PosePart_Transform; }
+static uint32_t GetPosePart(const LinearSegmentKinematicsDatagram&) { return PosePart_Velocity; }
+
+template<typename Message>
+void MVNStreamSource::ReceiveMVNData(const Message& message)
+{
+    AvatarPipeline* avatar = GetAvatar(message);
+    if (!avatar)
+        return;
+
+    if (require_linear_kinematics_) {
+        // Parts of a sample are collected outside the lock, only a whole pose is published
+        PoseSample* pending = avatar->assembler.acquire(message.sampleCounter());
+        if (!pending)
+            return;
+
+        message.forEachRecord(avatar->segment_ids, [pending, &message](int32_t segment_id, const float* fields) {
+            ApplySegmentData(message, fields, *pending, segment_id - 1);
+        });
+        pending->receive_time_ns = std::max(pending->receive_time_ns, message.receiveTimeNs());
+
+        if (!avatar->assembler.complete(message.sampleCounter(), GetPosePart(message)))
+            return;
+
+        std::scoped_lock<std::mutex> lock(avatar->pose_write_mtx);
+        PoseSample& pose = avatar->published_pose.BeginWrite();
+        for (auto segment : avatar->segments)
+            pose.CopySegment(*pending, segment);
+        pose.pose_id = pending->pose_id;
+        pose.receive_time_ns = pending->receive_time_ns;
+        avatar->published_pose.EndWrite();
+        return;
+    }
+
+    // One pass from the wire records of the tracked segments into the published pose, readers
+    // retry their copy if they overlap it
+    std::scoped_lock<std::mutex> lock(avatar->pose_write_mtx);
+    PoseSample& pose = avatar->published_pose.BeginWrite();
+
+    message.forEachRecord(avatar->segment_ids, [&pose, &message](int32_t segment_id, const float* fields) {
+        ApplySegmentData(message, fields, pose, segment_id - 1);
+    });
+
+    // The pose is as old as the newest packet of its sample that went into it
+    if (pose.pose_id != message.sampleCounter()) {
+        pose.pose_id = message.sampleCounter();
+        pose.receive_time_ns = message.receiveTimeNs();
     }
-    
-    // Save stored pose
-    if (pose_is_complete) {
-        QueuePose(incomplete_poses_[msg_id]);
-        incomplete_poses_.erase(msg_id);
+    else {
+        pose.receive_time_ns = std::max(pose.receive_time_ns, message.receiveTimeNs());
     }
+    avatar->published_pose.EndWrite();
+}
+
+void MVNStreamSource::DatagramVisitor::operator()(const MetaDatagram& message)
+{
+    source.ReceiveMVNMetaData(message);
+}
+
+void MVNStreamSource::DatagramVisitor::operator()(const QuaternionDatagram& message)
+{
+    source.ReceiveMVNData(message);
+}
+
+void MVNStreamSource::DatagramVisitor::operator()(const Unity3DDatagram& message)
+{
+    source.ReceiveMVNData(message);
+}
+
+void MVNStreamSource::DatagramVisitor::operator()(const LinearSegmentKinematicsDatagram& message)
+{
+    source.ReceiveMVNData(message);
 }
\ No newline at end of file
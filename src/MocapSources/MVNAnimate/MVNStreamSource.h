@@ -4,31 +4,84 @@
 #include <memory>
 #include <unordered_map>
 #include <mutex>
+#include <bitset>
+#include <vector>
 #include <IVRDriver.hpp>
 #include <IMocapStreamSource.hpp>
+#include <PosePublisher.hpp>
 #include <udpserver.h>
+#include <packetreplay.h>
 #include <concurrentqueue.h>
 
 #include "segments.h"
+#include "datagramdispatch.h"
+#include "poseassembler.h"
 
 class MVNStreamSource : public IMocapStreamSource {
 public:
 	virtual void init(MocapDriver::IVRDriver* owning_driver) override;
 	virtual void PopulateTrackers() override;
 	virtual MocapDriver::IVRDriver* GetDriver() override;
-	virtual PoseSample GetNextPose() override;
-	virtual void QueuePose(const PoseSample& pose);
+	virtual bool GetNextPose(int actorIndex, PoseSample& pose) override;
+	virtual void QueuePose(const PoseSample& pose, int actorIndex) override;
+	virtual int GetActorCount() override;
 	virtual std::string GetRenderModelPath(int segmentIndex);
 
 private:
-	void ReceiveMVNData(StreamingProtocol, const Datagram*);
+	// Everything one MVN avatar needs, so actors never share or block on each others poses
+	struct AvatarPipeline {
+		// Segments with a tracker, fixed before the first datagram arrives
+		std::vector<Segment> segments;
+		std::unordered_map<Segment, std::shared_ptr<MocapDriver::IVRDevice>> trackers;
 
-	std::string GetSettingsSegmentTarget(Segment segment);
+		// Wire IDs of those segments, the records read out of every pose packet
+		SegmentIdMask segment_ids;
+
+		// Packets are converted straight into this pose, GetNextPose copies it out without locking
+		PosePublisher published_pose;
+
+		// Keeps the receive thread and QueuePose from writing the pose at the same time, readers never take it
+		std::mutex pose_write_mtx;
+
+		// Holds a sample back until all of its parts have arrived, only used with RequireLinearKinematics
+		PoseAssembler assembler;
+
+		// Identity as reported by the avatar's meta data datagram, and the string it came from
+		std::string meta_content;
+		std::string name;
+		std::string color;
+		std::string xmid;
+	};
+
+	// Handlers for the datagrams the driver consumes, called straight from dispatchDatagram
+	struct DatagramVisitor {
+		MVNStreamSource& source;
+
+		void operator()(const MetaDatagram& message);
+		void operator()(const QuaternionDatagram& message);
+		void operator()(const Unity3DDatagram& message);
+		void operator()(const LinearSegmentKinematicsDatagram& message);
+		void operator()(const Datagram&) {}
+	};
+
+	AvatarPipeline* GetAvatar(const Datagram& message);
+	template<typename Message> void ReceiveMVNData(const Message& message);
+	void ReceiveMVNMetaData(const MetaDatagram& message);
+
+	DatagramFilter GetDatagramFilter();
+	std::string GetSettingsSegmentTarget(Segment segment, int avatarId);
+	std::string GetSettingsString(const std::string& key);
+	int GetSettingsInt(const std::string& key, int fallback);
+	bool GetSettingsBool(const std::string& key, bool fallback);
+	int GetSettingsAvatarCount();
 	MocapDriver::IVRDriver* driver_;
-	std::unordered_map<Segment, std::shared_ptr<MocapDriver::IVRDevice>> trackers_;
-	std::unique_ptr<UdpServer> mvn_udp_server_;
 
-	std::mutex pose_update_mtx;
-	std::map <int32_t, PoseSample> incomplete_poses_;
-	PoseSample completed_pose_;
+	std::vector<std::unique_ptr<AvatarPipeline>> avatars_;
+	std::bitset<256> unknown_avatars_;
+	bool require_linear_kinematics_ = false;
+	DatagramVisitor datagram_visitor_{ *this };
+
+	// Declared after the pipelines, so the receive threads stop before the pipelines are destroyed
+	std::unique_ptr<UdpServer> mvn_udp_server_;
+	std::unique_ptr<PacketReplay> mvn_replay_;
  };
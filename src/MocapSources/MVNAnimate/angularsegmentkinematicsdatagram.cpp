@@ -25,7 +25,7 @@
 */
 
 #include "angularsegmentkinematicsdatagram.h"
-#include <xstypes/xsmath.h>
+#include "mvnmath.h"
 
 /*! \class AngularSegmentKinematicsDatagram
 	\brief a Angular Kinematics datagram (type 0x22)
@@ -61,6 +61,30 @@ AngularSegmentKinematicsDatagram::~AngularSegmentKinematicsDatagram()
 {
 }
 
+/*! Gather the record at \a index from the decoded columns */
+AngularSegmentKinematicsDatagram::Kinematics AngularSegmentKinematicsDatagram::record(size_t index) const
+{
+	Kinematics kin;
+	kin.segmentId = m_records.segmentId[index];
+	for (int k = 0; k < 4; k++)
+		kin.segmentOrien[k] = m_records.column(1 + k)[index];
+	for (int k = 0; k < 3; k++)
+		kin.angularVeloc[k] = m_records.column(5 + k)[index];
+	for (int k = 0; k < 3; k++)
+		kin.angularAccel[k] = m_records.column(8 + k)[index];
+	return kin;
+}
+
+/*! The record of \a segmentIdx, with a segmentId of -1 if the packet did not contain it */
+AngularSegmentKinematicsDatagram::Kinematics AngularSegmentKinematicsDatagram::GetSegmentData(Segment segmentIdx) const
+{
+	// ID is index + 1 accoring to https://www.xsens.com/hubfs/Downloads/Manuals/MVN_real-time_network_streaming_protocol_specification.pdf
+	int index = m_records.find(segmentIdx + 1);
+	if (index < 0)
+		return Kinematics{-1};
+	return record(index);
+}
+
 /*! Deserialize the data from \a arr
 	\sa serializeData
 */
@@ -68,35 +92,20 @@ void AngularSegmentKinematicsDatagram::deserializeData(Streamer &inputStreamer)
 {
 	Streamer* streamer = &inputStreamer;
 
-	for (int i = 0; i < dataCount(); i++)
+	// Every item is a fixed 44 byte record, so the array is decoded in one go (or just the filtered segments)
+	const uint8_t* records = nullptr;
+	if (!streamer->readBlock(records, dataCount() * m_records.RecordSize)) {
+		m_records.clear();
+		return;
+	}
+	RecordDecoder::decode(records, dataCount(), segmentFilter(), m_records);
+
+	// trasform in degrees
+	for (size_t field = 1; field <= 10; field++)
 	{
-		Kinematics kin;
-
-		// Store the segement Id -> 4 byte
-		streamer->read(kin.segmentId);
-
-		// Store the Segment orientation in a Vector -> 16 byte	(4 x 4 byte)
-		for (int k = 0; k < 4; k++)
-			streamer->read(kin.segmentOrien[k]);
-		// trasform in degrees
-		for (int k = 0; k < 4; k++)
-			kin.segmentOrien[k] = XsMath_rad2deg(kin.segmentOrien[k]);
-
-		// Store the Angular Velocity in a Vector -> 12 byte	(3 x 4 byte)
-		for (int k = 0; k < 3; k++)
-			streamer->read(kin.angularVeloc[k]);
-		// trasform in degrees
-		for (int k = 0; k < 3; k++)
-			kin.angularVeloc[k] = XsMath_rad2deg(kin.angularVeloc[k]);
-
-		// Store the Angular Acceleration in a Vector -> 12 byte	(3 x 4 byte)
-		for (int k = 0; k < 3; k++)
-			streamer->read(kin.angularAccel[k]);
-		// trasform in degrees
-		for (int k = 0; k < 3; k++)
-			kin.angularAccel[k] = XsMath_rad2deg(kin.angularAccel[k]);
-
-		m_data.push_back(kin);
+		float* values = m_records.column(field);
+		for (size_t i = 0; i < m_records.count; i++)
+			values[i] = MvnMath::rad2deg(values[i]);
 	}
 }
 
@@ -104,26 +113,28 @@ void AngularSegmentKinematicsDatagram::deserializeData(Streamer &inputStreamer)
 */
 void AngularSegmentKinematicsDatagram::printData() const
 {
-	for (int i = 0; i < m_data.size(); i++)
+	for (size_t i = 0; i < m_records.count; i++)
 	{
-		std::cout << "Segment ID: " << m_data.at(i).segmentId << std::endl;
+		const Kinematics kin = record(i);
+
+		std::cout << "Segment ID: " << kin.segmentId << std::endl;
 		// Segment orientation quaternion
 		std::cout << "Segment orientation: " << "(";
-		std::cout << "re: " << m_data.at(i).segmentOrien[0] << ", ";
-		std::cout << "i: " << m_data.at(i).segmentOrien[1] << ", ";
-		std::cout << "j: " << m_data.at(i).segmentOrien[1] << ", ";
-		std::cout << "k: " << m_data.at(i).segmentOrien[2] << ")"<< std::endl;
+		std::cout << "re: " << kin.segmentOrien[0] << ", ";
+		std::cout << "i: " << kin.segmentOrien[1] << ", ";
+		std::cout << "j: " << kin.segmentOrien[1] << ", ";
+		std::cout << "k: " << kin.segmentOrien[2] << ")"<< std::endl;
 
 		// Angular Velocity
 		std::cout << "Angular velocity: " << "(";
-		std::cout << "x: " << m_data.at(i).angularVeloc[0] << ", ";
-		std::cout << "y: " << m_data.at(i).angularVeloc[1] << ", ";
-		std::cout << "z: " << m_data.at(i).angularVeloc[2] << ")"<< std::endl;
+		std::cout << "x: " << kin.angularVeloc[0] << ", ";
+		std::cout << "y: " << kin.angularVeloc[1] << ", ";
+		std::cout << "z: " << kin.angularVeloc[2] << ")"<< std::endl;
 
 		// Angular acceleration
 		std::cout << "Angular acceleration: " << "(";
-		std::cout << "x: " << m_data.at(i).angularAccel[0] << ", ";
-		std::cout << "y: " << m_data.at(i).angularAccel[1] << ", ";
-		std::cout << "z: " << m_data.at(i).angularAccel[2] << ")"<< std::endl << std::endl;
+		std::cout << "x: " << kin.angularAccel[0] << ", ";
+		std::cout << "y: " << kin.angularAccel[1] << ", ";
+		std::cout << "z: " << kin.angularAccel[2] << ")"<< std::endl << std::endl;
 	}
 }
@@ -28,25 +28,29 @@
 #define ANGULARSEGMENTSKINEMATICSDATAGRAM_H
 
 #include "datagram.h"
+#include "recorddecoder.h"
+#include <segments.h>
 
 class AngularSegmentKinematicsDatagram : public Datagram {
 public:
 	AngularSegmentKinematicsDatagram();
 	virtual ~AngularSegmentKinematicsDatagram();
 	virtual void printData() const override;
-
-protected:
-	virtual void deserializeData(Streamer &inputStreamer) override;
-
-private:
 	struct Kinematics {
 		int segmentId;
 		float segmentOrien[4];
 		float angularVeloc[3];
 		float angularAccel[3];
 	};
+	Kinematics GetSegmentData(Segment segmentIdx) const;
+
+protected:
+	virtual void deserializeData(Streamer &inputStreamer) override;
+
+private:
+	Kinematics record(size_t index) const;
 
-	std::vector<Kinematics> m_data;
+	RecordColumns<11, MaxDataCount> m_records;
 };
 
 #endif
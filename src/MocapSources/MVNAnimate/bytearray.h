@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/*! \class ByteArray
+	\brief An owned, contiguous buffer holding one raw packet
+
+	Only used where a packet has to outlive the receive buffer it arrived in, such as when it is
+	handed over as a copy. The receive path itself parses packets in place from a DatagramBatch.
+*/
+class ByteArray
+{
+public:
+	ByteArray() = default;
+	explicit ByteArray(size_t size) : m_data(size) {}
+	ByteArray(const uint8_t* data, size_t size) : m_data(data, data + size) {}
+
+	inline const uint8_t* data() const { return m_data.data(); }
+	inline uint8_t* data() { return m_data.data(); }
+	inline size_t size() const { return m_data.size(); }
+	inline bool empty() const { return m_data.empty(); }
+
+	inline uint8_t operator[](size_t index) const { return m_data[index]; }
+	inline uint8_t& operator[](size_t index) { return m_data[index]; }
+
+	inline void assign(const uint8_t* data, size_t size) { m_data.assign(data, data + size); }
+	inline void resize(size_t size) { m_data.resize(size); }
+	inline void clear() { m_data.clear(); }
+
+private:
+	std::vector<uint8_t> m_data;
+};
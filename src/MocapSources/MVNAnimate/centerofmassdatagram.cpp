@@ -60,16 +60,13 @@ void CenterOfMassDatagram::deserializeData(Streamer &inputStreamer)
 	Streamer* streamer = &inputStreamer;
 
 	// extract the coordinates of the position
-	for (int k = 0; k < 3; k++)
-		streamer->read(m_pos[k]);
+	streamer->read(m_pos, 3);
 
 	// extract the coordinates of the velocity
-	for (int k = 0; k < 3; k++)
-		streamer->read(m_vel[k]);
+	streamer->read(m_vel, 3);
 
 	// extract the coordinates of the acc
-	for (int k = 0; k < 3; k++)
-		streamer->read(m_acc[k]);
+	streamer->read(m_acc, 3);
 }
 
 /*! Print Data datagram in a formatted way
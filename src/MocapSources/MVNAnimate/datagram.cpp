@@ -25,7 +25,7 @@
 */
 
 #include "datagram.h"
-#include <xstypes/xstimestamp.h>
+#include <cstring>
 
 /*! \class Datagram
 
@@ -39,21 +39,113 @@
 
 const float Datagram::EULERPOSITIONSCALE = 100.0;
 
+namespace
+{
+	// ASCII hex digit to its value, 0xFF for anything else
+	struct HexDigitTable
+	{
+		uint8_t value[256];
+
+		constexpr HexDigitTable() : value()
+		{
+			for (int c = 0; c < 256; c++)
+				value[c] = 0xFF;
+			for (int c = '0'; c <= '9'; c++)
+				value[c] = (uint8_t)(c - '0');
+			for (int c = 'a'; c <= 'f'; c++)
+				value[c] = (uint8_t)(c - 'a' + 10);
+			for (int c = 'A'; c <= 'F'; c++)
+				value[c] = (uint8_t)(c - 'A' + 10);
+		}
+	};
+
+	// User friendly StreamingProtocol names, indexed by protocol code
+	struct ProtocolNameTable
+	{
+		const char* name[SPProtocolCount];
+
+		constexpr ProtocolNameTable() : name()
+		{
+			for (int p = 0; p < SPProtocolCount; p++)
+				name[p] = "";
+
+			name[SPPoseEuler] = "Position + Orientation (Euler)";
+			name[SPPoseQuaternion] = "Position + Orientation (Quaternion)";
+			name[SPPosePositions] = "Virtual Optical Marker Set";
+			name[SPJackProcessSimulate] = "Siemens Tecnomatix";
+			name[SPPoseUnity3D] = "Unity 3D";
+
+			name[SPMetaMoreMeta] = "Character Meta Data";
+			name[SPMetaScaling] = "Scaling Data";
+
+			name[SPJointAngles] = "Joint Angles";
+			name[SPLinearSegmentKinematics] = "Linear Segment Kinematics";
+			name[SPAngularSegmentKinematics] = "Angular Segment Kinematics";
+			name[SPTrackerKinematics] = "Tracker Kinematics";
+			name[SPCenterOfMass] = "Center of Mass";
+			name[SPTimeCode] = "Time Code";
+		}
+	};
+
+	constexpr HexDigitTable HexDigits;
+	constexpr ProtocolNameTable ProtocolNames;
+
+	// Protocol code from the two hex digits after "MXTP", or SPUnknown
+	inline int decodeProtocol(const uint8_t* id)
+	{
+		uint8_t high = HexDigits.value[id[4]];
+		uint8_t low = HexDigits.value[id[5]];
+		if ((high | low) & 0xF0)
+			return SPUnknown;
+		return (high << 4) | low;
+	}
+}
+
+/*! Decode the 24 byte header at the start of \a data into \a header
+
+	Returns false if the packet is too short or does not start with an "MXTPxx" ID string.
+	No allocation takes place, every field is a fixed offset load.
+*/
+bool DatagramHeader::parse(const uint8_t* data, size_t size, DatagramHeader& header)
+{
+	if (size < Size || memcmp(data, "MXTP", 4) != 0)
+		return false;
+
+	int protocol = decodeProtocol(data);
+	if (protocol == SPUnknown)
+		return false;
+
+	header.protocol = (uint8_t)protocol;
+	header.sampleCounter = WireOrder::load<int32_t>(data + 6);			// 4 bytes
+	header.datagramCounter = data[10];									// 1 byte
+	header.dataCount = data[11];										// 1 byte
+	header.frameTime = WireOrder::load<int32_t>(data + 12);				// 4 bytes
+	header.avatarId = data[16];											// 1 byte
+	header.bodySegmentCount = data[17];					// 1 byte, introduced in MVN 2019 / 2018.3 beta
+	header.propCount = data[18];						// 1 byte, introduced in MVN 2019 / 2018.3 beta
+	header.fingerTrackingSegmentCount = data[19];		// 1 byte, introduced in MVN 2019 / 2018.3 beta
+																		// 2 reserved bytes
+	header.dataSize = WireOrder::load<uint16_t>(data + 22);				// 2 bytes, introduced in MVN 2018
+	return true;
+}
+
 Datagram::Datagram()
-	: m_header("MXTP00")
-	, m_avatarId(0)
-	, m_dgramCounter(0x80)
-	, m_dataCount(0)
-	, m_frameTime(0)
-	, m_sampleCounter(0)
-
-	, m_bodySegmentCount(23)
-	, m_propCount(0)
-	, m_fingerTrackingSegmentCount(0)
-
-	, m_dataSize(0)
 {
-	initMap(m_packetsName);
+	m_header.protocol = SPUnknown;
+	m_header.sampleCounter = 0;
+	m_header.datagramCounter = 0x80;
+	m_header.dataCount = 0;
+	m_header.frameTime = 0;
+	m_header.avatarId = 0;
+
+	m_header.bodySegmentCount = 23;
+	m_header.propCount = 0;
+	m_header.fingerTrackingSegmentCount = 0;
+
+	m_header.dataSize = 0;
+	m_receiveTimeNs = 0;
+	m_segmentFilter = nullptr;
+	m_decodeRecords = true;
 }
 
 /*! Destructor */
@@ -64,82 +156,68 @@ Datagram::~Datagram()
 /*! The data dimension of the datagram */
 int Datagram::getDataSize() const
 {
-	return m_dataSize;
+	return m_header.dataSize;
 }
 
 /*! The datagrams message type */
-int Datagram::messageType(const XsByteArray &array)
+int Datagram::messageType(const ByteArray &array)
 {
-	if (array[0] == '{')
-		return SPUnknown;
+	return messageType(array.data(), array.size());
+}
 
-	try
-	{
-		std::stringstream tp;
-		// extract the 5th and 6th digits that represent the code of the packet
-		tp << array[4] << array[5];
-		std::string type;
-		tp >> type;
-		// convert to hex
-		int sp = std::stoi(type,nullptr,16);
-
-		return sp;
-	}
-	catch (...)
-	{
+/*! The message type of the packet in \a data */
+int Datagram::messageType(const uint8_t* data, size_t size)
+{
+	// JSON control messages such as {"type":"transport","value":"record"} start with a brace
+	if (size < 6 || data[0] == '{')
 		return SPUnknown;
-	}
+
+	// extract the 5th and 6th digits that represent the code of the packet
+	return decodeProtocol(data);
 }
 
 /*! The datagrams message type */
 int Datagram::messageType() const
 {
-	std::string header = m_header;
-	std::string type = header.substr(4, header.size()-4);
-	int sp = std::stoi (type,nullptr,16);
-
-	return sp;
+	return m_header.protocol;
 }
 
 /*! Set the type of the message */
 void Datagram::setType(StreamingProtocol proto)
 {
-	std::stringstream hexSS;
-	hexSS.width(2);
-	hexSS.fill('0');
-	hexSS << std::hex << proto;
-	m_header = "MXTP" +  hexSS.str();
+	m_header.protocol = (uint8_t)proto;
 }
 
 /*! Deserializes the datagram from given byte array \a arr.
 */
-bool Datagram::deserialize(const XsByteArray& arr)
+bool Datagram::deserialize(const ByteArray& arr)
 {
-	Streamer streamer(arr);
-	std::string messageType;
-
-	// extract only the byte for the header (24 bytes)
-	streamer.read(messageType,6);		// 6 bytes
-	streamer.read(m_sampleCounter);		// 4 bytes
-	streamer.read(m_dgramCounter);		// 1 byte
-	streamer.read(m_dataCount);			// 1 byte
-	streamer.read(m_frameTime);			// 4 bytes
-	streamer.read(m_avatarId);			// 1 byte
+	return deserialize(arr.data(), arr.size());
+}
 
-	streamer.read(m_bodySegmentCount);				// 1 byte, introduced in MVN 2019 / 2018.3 beta
-	streamer.read(m_propCount);						// 1 byte, introduced in MVN 2019 / 2018.3 beta
-	streamer.read(m_fingerTrackingSegmentCount);	// 1 byte, introduced in MVN 2019 / 2018.3 beta
+/*! Deserializes the datagram in place from the packet at \a data, without copying it.
+	Returns false if the packet is shorter than its header and item count claim.
+*/
+bool Datagram::deserialize(const uint8_t* data, size_t size)
+{
+	DatagramHeader header;
+	if (!DatagramHeader::parse(data, size, header))
+		return false;
+	return deserialize(header, data, size);
+}
 
-	uint8_t reserved;
-	streamer.read(reserved);			// 1 byte
-	streamer.read(reserved);			// 1 byte
+/*! Deserializes the packet at \a data whose header was already decoded into \a header */
+bool Datagram::deserialize(const DatagramHeader& header, const uint8_t* data, size_t size)
+{
+	m_header = header;
 
-	streamer.read(m_dataSize);			// 2 bytes, introduced in MVN 2018
+	Streamer streamer(data, size);
+	streamer.skip(DatagramHeader::Size);
 
 	// deserialize the data part of the Packet
 	deserializeData(streamer);
 
-	return true;
+	return streamer.ok();
 }
 
 void Datagram::printHeader() const
@@ -167,7 +245,7 @@ void Datagram::printHeader() const
 */
 uint8_t Datagram::avatarId() const
 {
-	return m_avatarId;
+	return m_header.avatarId;
 }
 
 /*! Return the amount of data items in this datagram
@@ -176,19 +254,19 @@ uint8_t Datagram::avatarId() const
 */
 uint8_t Datagram::dataCount() const
 {
-	return m_dataCount;
+	return m_header.dataCount;
 }
 
 /*! Set the number of items in this packet */
 void Datagram::setDataCount(uint8_t c)
 {
-	m_dataCount = c;
+	m_header.dataCount = c;
 }
 
 /*! The sample counter is a 32-bit unsigned integer value which is incremented by one each time a new set of motion sensor data is sampled and sent away. Note that the sample counter is not to be interpreted as a time code, since the sender may skip frames. */
 int32_t Datagram::sampleCounter() const
 {
-	return m_sampleCounter;
+	return m_header.sampleCounter;
 }
 
 /*! Return the datagram counter
@@ -211,7 +289,7 @@ This also means that the combination of sample counter and datagram counter valu
 */
 uint8_t Datagram::datagramCounter() const
 {
-	return m_dgramCounter;
+	return m_header.datagramCounter;
 }
 
 /*! The frametime associated with this datagram
@@ -220,40 +298,16 @@ uint8_t Datagram::datagramCounter() const
 */
 int32_t Datagram::frameTime() const
 {
-	return m_frameTime;
-}
-
-/*! Map the StreamingProtocol names to a user friendly version
-*/
-void Datagram::initMap(std::map<int, std::string> &map)
-{
-	map[SPPoseEuler] = "Position + Orientation (Euler)";
-	map[SPPoseQuaternion] = "Position + Orientation (Quaternion)";
-	map[SPPosePositions] = "Virtual Optical Marker Set";
-	map[SPJackProcessSimulate] = "Siemens Tecnomatix";
-	map[SPPoseUnity3D] = "Unity 3D";
-
-	map[SPMetaMoreMeta] = "Character Meta Data";
-	map[SPMetaScaling] = "Scaling Data";
-
-	map[SPJointAngles] = "Joint Angles";
-	map[SPLinearSegmentKinematics] = "Linear Segment Kinematics";
-	map[SPAngularSegmentKinematics] = "Angular Segment Kinematics";
-	map[SPTrackerKinematics] = "Tracker Kinematics";
-	map[SPCenterOfMass] = "Center of Mass";
-	map[SPTimeCode] = "Time Code";
+	return m_header.frameTime;
 }
 
 /*! Convert the StreamingProtocol to user frindly string name
 */
-std::string Datagram::decode(StreamingProtocol proto) const
+const char* Datagram::decode(StreamingProtocol proto)
 {
-	if(m_packetsName.find(proto) != m_packetsName.end())
-	{
-		//element found;
-		return m_packetsName.find(proto)->second;
-	}
-	return std::string();
+	if (proto < 0 || proto >= SPProtocolCount)
+		return "";
+	return ProtocolNames.name[proto];
 }
 
 void Datagram::convertFromYupToZup(float *vector) const
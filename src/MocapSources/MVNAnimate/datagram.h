@@ -34,6 +34,7 @@
 #include <vector>
 
 #include "streamer.h"
+#include "segmenttable.h"
 
 enum StreamingProtocol {
 	SPPoseEuler = 0x01,
@@ -59,13 +60,42 @@ enum StreamingProtocol {
 	SPUnknown = 0	// different kind of protocol than the above, example: {"type":"transport","value":"record"}
 };
 
+// One past the highest protocol code, for tables indexed by protocol
+const int SPProtocolCount = SPTimeCode + 1;
+
+// Wire segment IDs to decode, see Datagram::setSegmentFilter
+typedef SegmentMask<256> SegmentIdMask;
+
+/*! \struct DatagramHeader
+	\brief The 24 byte header that starts every MXTP datagram, decoded in host order
+*/
+struct DatagramHeader
+{
+	static const size_t Size = 24;
+
+	uint8_t protocol;
+	int32_t sampleCounter;
+	uint8_t datagramCounter;
+	uint8_t dataCount;
+	int32_t frameTime;
+	uint8_t avatarId;
+	uint8_t bodySegmentCount;
+	uint8_t propCount;
+	uint8_t fingerTrackingSegmentCount;
+	uint16_t dataSize;
+
+	static bool parse(const uint8_t* data, size_t size, DatagramHeader& header);
+};
+
 class Datagram
 {
 public:
 	Datagram();
-	~Datagram();
+	virtual ~Datagram();
 
-	bool deserialize(const XsByteArray& arr);
+	bool deserialize(const ByteArray& arr);
+	bool deserialize(const uint8_t* data, size_t size);
+	bool deserialize(const DatagramHeader& header, const uint8_t* data, size_t size);
 	void setDataCount(uint8_t c);
 	void setType(StreamingProtocol proto);
 	int32_t messageType() const;
@@ -75,12 +105,33 @@ public:
 	uint8_t dataCount() const;
 	uint8_t datagramCounter() const;
 
-	inline int bodySegmentCount() const { return m_bodySegmentCount; }
-	inline int propCount() const { return m_propCount; }
-	inline int fingerTrackingSegmentCount() const { return m_fingerTrackingSegmentCount; }
-
-	static int messageType(const XsByteArray& arr);
-	std::string decode(StreamingProtocol proto) const;
+	inline int bodySegmentCount() const { return m_header.bodySegmentCount; }
+	inline int propCount() const { return m_header.propCount; }
+	inline int fingerTrackingSegmentCount() const { return m_header.fingerTrackingSegmentCount; }
+	inline const DatagramHeader& header() const { return m_header; }
+
+	/*! Arrival time of the packet that completed this sample, in nanoseconds since the
+		system_clock epoch. 0 when the datagram did not come from a receiver.
+	*/
+	inline uint64_t receiveTimeNs() const { return m_receiveTimeNs; }
+	inline void setReceiveTimeNs(uint64_t ns) { m_receiveTimeNs = ns; }
+
+	/*! Decode only the segment records whose ID is in \a filter, or all of them when it is null.
+		Only datagrams made of per-segment records honour it. The mask is not copied.
+	*/
+	inline void setSegmentFilter(const SegmentIdMask* filter) { m_segmentFilter = filter; }
+	inline const SegmentIdMask* segmentFilter() const { return m_segmentFilter; }
+
+	/*! With record decoding off, datagrams made of segment records only remember where their
+		records are in the packet, for a consumer that reads them with forEachRecord(). Those
+		records are only valid until the datagram callback returns.
+	*/
+	inline void setDecodeRecords(bool decode) { m_decodeRecords = decode; }
+	inline bool decodeRecords() const { return m_decodeRecords; }
+
+	static int messageType(const ByteArray& arr);
+	static int messageType(const uint8_t* data, size_t size);
+	static const char* decode(StreamingProtocol proto);
 
 	void convertFromYupToZup(float *vector) const;
 
@@ -91,23 +142,16 @@ protected:
 	virtual void deserializeData(Streamer &inputStreamer) = 0;
 	static const float EULERPOSITIONSCALE;
 
-private:
-	std::string m_header;
-	int32_t m_sampleCounter;
-	int32_t m_frameTime;
-	uint8_t m_avatarId;
-	uint8_t m_dataCount;
-	uint8_t m_dgramCounter;
+	// The item count is a single byte, so no packet carries more than this many records
+	static const int MaxDataCount = 255;
 
-	uint8_t m_bodySegmentCount;
-	uint8_t m_propCount;
-	uint8_t m_fingerTrackingSegmentCount;
-
-	uint16_t m_dataSize;
+private:
+	DatagramHeader m_header;
+	uint64_t m_receiveTimeNs;
+	const SegmentIdMask* m_segmentFilter;
+	bool m_decodeRecords;
 
 	int getDataSize() const;
-	void initMap(std::map<int, std::string> &map);
-	std::map<int, std::string> m_packetsName;
 };
 
 #endif
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/*! \class DatagramBatch
+	\brief A fixed set of receive slots filled by a single UdpReceiver::receive call
+
+	Storage for every slot is allocated once up front and reused for every batch, so receiving
+	does not touch the heap. Each slot holds one UDP payload of at most MaxDatagramSize bytes and
+	the time it arrived, in nanoseconds since the system_clock epoch (CLOCK_REALTIME on Linux).
+*/
+class DatagramBatch
+{
+public:
+	static constexpr size_t MaxDatagrams = 64;
+	static constexpr size_t MaxDatagramSize = 4096;
+
+	DatagramBatch()
+		: m_storage(MaxDatagrams * MaxDatagramSize)
+		, m_sizes(MaxDatagrams, 0)
+		, m_receiveTimes(MaxDatagrams, 0)
+		, m_count(0)
+	{
+	}
+
+	// The clock receive times are taken on, shared with the driver so latencies can be measured
+	static inline uint64_t nowNs()
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	}
+
+	inline size_t count() const { return m_count; }
+	inline bool empty() const { return m_count == 0; }
+	inline const uint8_t* data(size_t index) const { return m_storage.data() + index * MaxDatagramSize; }
+	inline size_t size(size_t index) const { return m_sizes[index]; }
+	inline uint64_t receiveTimeNs(size_t index) const { return m_receiveTimes[index]; }
+
+	inline uint8_t* slot(size_t index) { return m_storage.data() + index * MaxDatagramSize; }
+	inline void setSize(size_t index, size_t size) { m_sizes[index] = size; }
+	inline void setReceiveTime(size_t index, uint64_t ns) { m_receiveTimes[index] = ns; }
+	inline void setCount(size_t count) { m_count = count; }
+	inline void clear() { m_count = 0; }
+
+private:
+	std::vector<uint8_t> m_storage;
+	std::vector<size_t> m_sizes;
+	std::vector<uint64_t> m_receiveTimes;
+	size_t m_count;
+};
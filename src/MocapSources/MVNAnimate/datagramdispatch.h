@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <type_traits>
+
+#include "angularsegmentkinematicsdatagram.h"
+#include "centerofmassdatagram.h"
+#include "eulerdatagram.h"
+#include "jointanglesdatagram.h"
+#include "linearsegmentkinematicsdatagram.h"
+#include "metadatagram.h"
+#include "positiondatagram.h"
+#include "quaterniondatagram.h"
+#include "scaledatagram.h"
+#include "timecodedatagram.h"
+#include "trackerkinematicsdatagram.h"
+#include "unity3ddatagram.h"
+
+/*! Call \a visitor with \a datagram as the concrete type ParserManager decodes \a protocol into.
+
+	The protocol is switched on once and every case calls the visitor overload for that type
+	directly, so handlers can be inlined. A visitor needs an operator() for every type it handles
+	and one taking const Datagram& for everything else.
+*/
+template<typename Visitor>
+inline void dispatchDatagram(StreamingProtocol protocol, const Datagram& datagram, Visitor& visitor)
+{
+	switch (protocol)
+	{
+	case SPPoseEuler: visitor(static_cast<const EulerDatagram&>(datagram)); break;
+	case SPPoseQuaternion: visitor(static_cast<const QuaternionDatagram&>(datagram)); break;
+	case SPPosePositions: visitor(static_cast<const PositionDatagram&>(datagram)); break;
+	case SPPoseUnity3D: visitor(static_cast<const Unity3DDatagram&>(datagram)); break;
+	case SPMetaMoreMeta: visitor(static_cast<const MetaDatagram&>(datagram)); break;
+	case SPMetaScaling: visitor(static_cast<const ScaleDatagram&>(datagram)); break;
+	case SPJointAngles: visitor(static_cast<const JointAnglesDatagram&>(datagram)); break;
+	case SPLinearSegmentKinematics: visitor(static_cast<const LinearSegmentKinematicsDatagram&>(datagram)); break;
+	case SPAngularSegmentKinematics: visitor(static_cast<const AngularSegmentKinematicsDatagram&>(datagram)); break;
+	case SPTrackerKinematics: visitor(static_cast<const TrackerKinematicsDatagram&>(datagram)); break;
+	case SPCenterOfMass: visitor(static_cast<const CenterOfMassDatagram&>(datagram)); break;
+	case SPTimeCode: visitor(static_cast<const TimeCodeDatagram&>(datagram)); break;
+	default: visitor(datagram); break;
+	}
+}
+
+/*! \class DatagramCallback
+	\brief Where ParserManager hands every decoded datagram
+
+	Either any callable taking (StreamingProtocol, const Datagram*), kept behind a std::function, or
+	a visitor bound with visitor(), which costs one plain function call per datagram followed by
+	dispatchDatagram. A bound visitor is not copied, it has to outlive the callback.
+*/
+class DatagramCallback
+{
+public:
+	typedef std::function<void(StreamingProtocol, const Datagram*)> Function;
+
+	DatagramCallback(std::nullptr_t = nullptr)
+		: m_invoke(nullptr)
+		, m_context(nullptr)
+	{
+	}
+
+	template<typename Callable, typename = typename std::enable_if<
+		!std::is_same<typename std::decay<Callable>::type, DatagramCallback>::value
+		&& !std::is_same<typename std::decay<Callable>::type, std::nullptr_t>::value>::type>
+	DatagramCallback(Callable callable)
+		: m_function(std::make_shared<Function>(std::move(callable)))
+		, m_invoke(&invokeFunction)
+		, m_context(m_function.get())
+	{
+	}
+
+	template<typename Visitor>
+	static DatagramCallback visitor(Visitor& visitor)
+	{
+		DatagramCallback callback;
+		callback.m_invoke = [](void* context, StreamingProtocol protocol, const Datagram* datagram) {
+			dispatchDatagram(protocol, *datagram, *static_cast<Visitor*>(context));
+		};
+		callback.m_context = &visitor;
+		return callback;
+	}
+
+	inline explicit operator bool() const { return m_invoke != nullptr; }
+
+	inline void operator()(StreamingProtocol protocol, const Datagram* datagram) const
+	{
+		m_invoke(m_context, protocol, datagram);
+	}
+
+private:
+	static void invokeFunction(void* context, StreamingProtocol protocol, const Datagram* datagram)
+	{
+		(*static_cast<Function*>(context))(protocol, datagram);
+	}
+
+	// Shared so copies of a callback wrapping a std::function stay valid
+	std::shared_ptr<Function> m_function;
+	void (*m_invoke)(void* context, StreamingProtocol protocol, const Datagram* datagram);
+	void* m_context;
+};
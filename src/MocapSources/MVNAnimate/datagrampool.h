@@ -0,0 +1,69 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "datagram.h"
+
+/*! \class DatagramPool
+	\brief A fixed set of preconstructed datagrams of one protocol
+
+	All instances are created up front by populate(), so acquiring and releasing a datagram while
+	parsing never allocates. A released datagram keeps its record capacity and is simply
+	overwritten by the next deserialize.
+*/
+class DatagramPool
+{
+public:
+	DatagramPool() = default;
+
+	DatagramPool(DatagramPool const&) = delete;
+	DatagramPool& operator=(DatagramPool const&) = delete;
+	DatagramPool(DatagramPool&&) = default;
+	DatagramPool& operator=(DatagramPool&&) = default;
+
+	template<typename T>
+	void populate(size_t count)
+	{
+		m_instances.clear();
+		m_free.clear();
+		m_instances.reserve(count);
+		m_free.reserve(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			m_instances.emplace_back(new T);
+			m_free.push_back(m_instances.back().get());
+		}
+	}
+
+	/*! Take an unused datagram from the pool, or nullptr if the pool is empty or exhausted */
+	inline Datagram* acquire()
+	{
+		if (m_free.empty())
+			return nullptr;
+		Datagram* datagram = m_free.back();
+		m_free.pop_back();
+		return datagram;
+	}
+
+	/*! Return a datagram taken with acquire() */
+	inline void release(Datagram* datagram)
+	{
+		m_free.push_back(datagram);
+	}
+
+	/*! Call \a visit(Datagram*) for every datagram of the pool, free or not */
+	template<typename Visitor>
+	void forEach(Visitor visit)
+	{
+		for (auto& instance : m_instances)
+			visit(instance.get());
+	}
+
+	inline size_t capacity() const { return m_instances.size(); }
+	inline size_t available() const { return m_free.size(); }
+
+private:
+	std::vector<std::unique_ptr<Datagram>> m_instances;
+	std::vector<Datagram*> m_free;
+};
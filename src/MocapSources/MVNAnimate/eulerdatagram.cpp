@@ -25,8 +25,7 @@
 */
 
 #include "eulerdatagram.h"
-#include <xstypes/xsquaternion.h>
-#include <xstypes/xseuler.h>
+#include "mvnmath.h"
 
 /*! \class EulerDatagram
 	\brief a Position & Euler orientation pose datagram (type 01)
@@ -52,6 +51,7 @@ EulerDatagram::EulerDatagram()
 	: Datagram()
 {
 	setType(SPPoseEuler);
+	m_data.reserve(MaxDataCount);
 }
 
 /*! Destructor */
@@ -59,6 +59,15 @@ EulerDatagram::~EulerDatagram()
 {
 }
 
+/*! The record of \a segmentIdx, with a segmentId of -1 if the packet did not contain it */
+EulerDatagram::Kinematics EulerDatagram::GetSegmentData(Segment segmentIdx) const
+{
+	int index = m_segments.find(segmentIdx + 1);
+	if (index < 0)
+		return Kinematics{-1};
+	return m_data[index];
+}
+
 /*! Deserialize the data from \a arr
 	\sa serializeData
 */
@@ -66,20 +75,23 @@ void EulerDatagram::deserializeData(Streamer &inputStreamer)
 {
 	Streamer* streamer = &inputStreamer;
 
+	// Pooled instances are reused, drop the previous packet without releasing capacity
+	m_data.clear();
+	m_segments.clear();
+
 	for (int i = 0; i < dataCount(); i++)
 	{
 		Kinematics kin;
 		float orientation[4];
 		float rotation[3];
-		XsQuaternion quaternion;
-		XsQuaternion tempQuat;
+		double euler[3];
+		double quaternion[4];
 
 		// Store the segement Id -> 4 byte
 		streamer->read(kin.segmentId);
 
 		// Store the position in a Vector. The coordinates use a Y-Up
-		for (int k = 0; k < 3; k++)
-			streamer->read(kin.pos[k]);
+		streamer->read(kin.pos, 3);
 
 		for (int k = 0; k < 3; k++)
 			kin.pos[k] /= EULERPOSITIONSCALE;
@@ -88,25 +100,30 @@ void EulerDatagram::deserializeData(Streamer &inputStreamer)
 		convertFromYupToZup(kin.pos);
 
 		// The rotation is based to the coordinates Y-Up
-		for (int k = 0; k < 3; k++)
-			streamer->read(rotation[k]);
+		streamer->read(rotation, 3);
 
 		// create Euler vector based from the rotation cordinates
-		XsEuler euler(rotation[0], rotation[1], rotation[2]);
+		for (int k = 0; k < 3; k++)
+			euler[k] = rotation[k];
 
 		// convert the Euler vector to quaternion
-		quaternion.fromEulerAngles(euler);
+		MvnMath::quaternionFromEuler(euler, quaternion);
 
 		// create a quaternion with the inverted components (x,y,z)
-		tempQuat = XsQuaternion(quaternion[0], quaternion[3], quaternion[1], quaternion[2]);
+		double tempQuat[4] = { quaternion[0], quaternion[3], quaternion[1], quaternion[2] };
 
 		// covert from Euler to Quaternion again
-		euler.fromQuaternion(tempQuat);
+		MvnMath::eulerFromQuaternion(tempQuat, euler);
 
 		kin.rotation[0] = euler[0];
 		kin.rotation[1] = euler[1];
 		kin.rotation[2] = euler[2];
 
+		if (!streamer->ok())
+			break;
+
+		if (!m_segments.contains(kin.segmentId))
+			m_segments.set(kin.segmentId, m_data.size());
 		m_data.push_back(kin);
 	}
 }
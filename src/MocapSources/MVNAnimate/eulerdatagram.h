@@ -25,27 +25,30 @@
 */
 
 #ifndef EULERDATAGRAM_H
-#define EULERATAGRAM_H
+#define EULERDATAGRAM_H
 
 #include "datagram.h"
+#include "segmenttable.h"
+#include <segments.h>
 
 class EulerDatagram : public Datagram {
 public:
 	EulerDatagram();
 	virtual ~EulerDatagram();
 	virtual void printData() const override;
-
-protected:
-	virtual void deserializeData(Streamer &inputStreamer) override;
-
-private:
 	struct Kinematics {
 		int32_t segmentId;
 		float pos[3];
 		float rotation[3];
 	};
+	Kinematics GetSegmentData(Segment segmentIdx) const;
 
+protected:
+	virtual void deserializeData(Streamer &inputStreamer) override;
+
+private:
 	std::vector<Kinematics> m_data;
+	SegmentTable<256> m_segments;
 };
 
 #endif
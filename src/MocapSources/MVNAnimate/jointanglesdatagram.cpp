@@ -47,6 +47,7 @@ JointAnglesDatagram::JointAnglesDatagram()
 	: Datagram()
 {
 	setType(SPJointAngles);
+	m_data.reserve(MaxDataCount);
 }
 
 /*! Destructor */
@@ -61,6 +62,9 @@ void JointAnglesDatagram::deserializeData(Streamer &inputStreamer)
 {
 	Streamer* streamer = &inputStreamer;
 
+	// Pooled instances are reused, drop the previous packet without releasing capacity
+	m_data.clear();
+
 	for (int i = 0; i < dataCount(); i++)
 	{
 		Joint joint;
@@ -72,8 +76,10 @@ void JointAnglesDatagram::deserializeData(Streamer &inputStreamer)
 		streamer->read(joint.child);
 
 		// Store the Rotation in a Vector -> 12 byte	(3 x 4 byte)
-		for (int k = 0; k < 3; k++)
-			streamer->read(joint.rotation[k]);
+		streamer->read(joint.rotation, 3);
+
+		if (!streamer->ok())
+			break;
 
 		m_data.push_back(joint);
 	}
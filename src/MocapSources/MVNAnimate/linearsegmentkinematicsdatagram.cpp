@@ -50,6 +50,8 @@
 /*! Constructor */
 LinearSegmentKinematicsDatagram::LinearSegmentKinematicsDatagram()
 	: Datagram()
+	, m_wire(nullptr)
+	, m_wireCount(0)
 {
 	setType(SPLinearSegmentKinematics);
 }
@@ -59,71 +61,78 @@ LinearSegmentKinematicsDatagram::~LinearSegmentKinematicsDatagram()
 {
 }
 
+/*! Gather the record at \a index from the decoded columns */
+LinearSegmentKinematicsDatagram::Kinematics LinearSegmentKinematicsDatagram::record(size_t index) const
+{
+	Kinematics kin;
+	kin.segmentId = m_records.segmentId[index];
+	for (int k = 0; k < 3; k++)
+		kin.pos[k] = m_records.column(1 + k)[index];
+	for (int k = 0; k < 3; k++)
+		kin.velocity[k] = m_records.column(4 + k)[index];
+	for (int k = 0; k < 3; k++)
+		kin.acceleration[k] = m_records.column(7 + k)[index];
+	return kin;
+}
+
 /*! Deserialize the data from \a arr
 	\sa serializeData
 */
 LinearSegmentKinematicsDatagram::Kinematics LinearSegmentKinematicsDatagram::GetSegmentData(Segment segmentIdx) const
 {
 	// ID is index + 1 accoring to https://www.xsens.com/hubfs/Downloads/Manuals/MVN_real-time_network_streaming_protocol_specification.pdf
-	int segmentID = segmentIdx + 1;
-	auto segment_it = std::find_if(m_data.begin(), m_data.end(), [&segmentID](const Kinematics& arg) {
-		return arg.segmentId == segmentID;
-		});
-	if (segment_it != m_data.end()) {
-		return *segment_it;
-	}
-	return Kinematics{ -1 };
+	int index = m_records.find(segmentIdx + 1);
+	if (index < 0)
+		return Kinematics{-1};
+	return record(index);
 }
 void LinearSegmentKinematicsDatagram::deserializeData(Streamer &inputStreamer)
 {
 	Streamer* streamer = &inputStreamer;
 
-	for (int i = 0; i < dataCount(); i++)
-	{
-		Kinematics kin;
-
-		// Store the segement Id -> 4 byte
-		streamer->read(kin.segmentId);
-
-		// Store the Segment Position in a Vector -> 12 byte	(3 x 4 byte)
-		for (int k = 0; k < 3; k++)
-			streamer->read(kin.pos[k]);
-
-		// Store the Segment Velocity in a Vector -> 12 byte	(3 x 4 byte)
-		for (int k = 0; k < 3; k++)
-			streamer->read(kin.velocity[k]);
-
-		// Store the Segmetn Acceleration in a Vector -> 12 byte	(3 x 4 byte)
-		for (int k = 0; k < 3; k++)
-			streamer->read(kin.acceleration[k]);
+	// Every item is a fixed 40 byte record, so the array is decoded in one go (or just the filtered segments)
+	const uint8_t* records = nullptr;
+	if (!streamer->readBlock(records, dataCount() * m_records.RecordSize)) {
+		m_records.clear();
+		m_wireCount = 0;
+		return;
+	}
+	m_wire = records;
+	m_wireCount = dataCount();
 
-		m_data.push_back(kin);
+	// A consumer reading the records with forEachRecord does not need the columns
+	if (!decodeRecords()) {
+		m_records.clear();
+		return;
 	}
+	RecordDecoder::decode(records, dataCount(), segmentFilter(), m_records);
 }
 
 /*! Print Data datagram in a formatted way
 */
 void LinearSegmentKinematicsDatagram::printData() const
 {
-	for (int i = 0; i < m_data.size(); i++)
+	for (size_t i = 0; i < m_records.count; i++)
 	{
-		std::cout << "Segment ID: " << m_data.at(i).segmentId << std::endl;
+		const Kinematics kin = record(i);
+
+		std::cout << "Segment ID: " << kin.segmentId << std::endl;
 		// Segment Position
 		std::cout << "Segment Position: " << "(";
-		std::cout << "x: " << m_data.at(i).pos[0] << ", ";
-		std::cout << "y: " << m_data.at(i).pos[1] << ", ";
-		std::cout << "z: " << m_data.at(i).pos[2] << ")"<< std::endl;
+		std::cout << "x: " << kin.pos[0] << ", ";
+		std::cout << "y: " << kin.pos[1] << ", ";
+		std::cout << "z: " << kin.pos[2] << ")"<< std::endl;
 
 		// Segment Velocity
 		std::cout << "Segment Velocity: " << "(";
-		std::cout << "x: " << m_data.at(i).velocity[0] << ", ";
-		std::cout << "y: " << m_data.at(i).velocity[1] << ", ";
-		std::cout << "z: " << m_data.at(i).velocity[2] << ")"<< std::endl;
+		std::cout << "x: " << kin.velocity[0] << ", ";
+		std::cout << "y: " << kin.velocity[1] << ", ";
+		std::cout << "z: " << kin.velocity[2] << ")"<< std::endl;
 
 		// Segment Acceleration
 		std::cout << "Segment Acceleration: " << "(";
-		std::cout << "x: " << m_data.at(i).acceleration[0] << ", ";
-		std::cout << "y: " << m_data.at(i).acceleration[1] << ", ";
-		std::cout << "z: " << m_data.at(i).acceleration[2] << ")"<< std::endl << std::endl;
+		std::cout << "x: " << kin.acceleration[0] << ", ";
+		std::cout << "y: " << kin.acceleration[1] << ", ";
+		std::cout << "z: " << kin.acceleration[2] << ")"<< std::endl << std::endl;
 	}
 }
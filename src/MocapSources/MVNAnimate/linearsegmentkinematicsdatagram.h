@@ -28,6 +28,7 @@
 #define LINEARSEGMENTKINEMATICSDATAGRAM_H
 
 #include "datagram.h"
+#include "recorddecoder.h"
 #include <segments.h>
 
 class LinearSegmentKinematicsDatagram : public Datagram {
@@ -42,14 +43,30 @@ public:
 		float acceleration[3];
 	};
 	Kinematics GetSegmentData(Segment segmentId) const;
-	
+
+	/*! Call \a sink(segmentId, fields) for the record of every segment in \a wanted, read straight
+		from the packet. The fields are position, velocity and acceleration, x y z each. Only valid
+		inside the datagram callback, while the packet is, see Datagram::setDecodeRecords.
+	*/
+	template<typename Sink>
+	inline size_t forEachRecord(const SegmentIdMask& wanted, Sink&& sink) const
+	{
+		return RecordDecoder::forEachRecord<10>(m_wire, m_wireCount, wanted, sink);
+	}
+
 protected:
 	virtual void deserializeData (Streamer &inputStreamer) override;
 
 private:
 
 
-	std::vector<Kinematics> m_data;
+	Kinematics record(size_t index) const;
+
+	RecordColumns<10, MaxDataCount> m_records;
+
+	// The records in the packet being handled, see forEachRecord
+	const uint8_t* m_wire;
+	size_t m_wireCount;
 };
 
 #endif
@@ -25,19 +25,81 @@
 */
 
 #include "udpserver.h"
+#include "packetreplay.h"
 #include "streamer.h"
-#include <conio.h>
-#include <xstypes/xstime.h>
+#include <iostream>
+#include <chrono>
 
+/*! Usage:
+	main [--capture file] [--latest]	listen on the MVN port, optionally recording every datagram,
+					and with --latest parse only the newest sample after a stall
+	     [--cpu n] [--realtime]		pin the receive thread to a core, run it at real-time priority
+	     [--spin us] [--busy-poll us]	poll before sleeping in receive, busy poll the socket
+	     [--group ip [--interface ip]]	join a multicast group, sharing the port with other listeners
+	main --replay file [--fast]		parse a capture with its original timing, or as fast as possible
+*/
 int main(int argc, char *argv[])
 {
 	std::string hostDestinationAddress = "localhost";
 	int port = 9763;
 
-	UdpServer udpServer(hostDestinationAddress, (uint16_t)port);
+	std::string multicastInterface;
+	std::string capturePath, replayPath;
+	bool fast = false;
+	bool latest = false;
+	ThreadScheduling scheduling;
+	uint32_t spinUs = 0, busyPollUs = 0;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--capture" && i + 1 < argc)
+			capturePath = argv[++i];
+		else if (arg == "--replay" && i + 1 < argc)
+			replayPath = argv[++i];
+		else if (arg == "--fast")
+			fast = true;
+		else if (arg == "--latest")
+			latest = true;
+		else if (arg == "--cpu" && i + 1 < argc)
+			scheduling.cpu = std::stoi(argv[++i]);
+		else if (arg == "--realtime")
+			scheduling.realtime = true;
+		else if (arg == "--spin" && i + 1 < argc)
+			spinUs = (uint32_t)std::stoul(argv[++i]);
+		else if (arg == "--busy-poll" && i + 1 < argc)
+			busyPollUs = (uint32_t)std::stoul(argv[++i]);
+		else if (arg == "--group" && i + 1 < argc)
+			hostDestinationAddress = argv[++i];
+		else if (arg == "--interface" && i + 1 < argc)
+			multicastInterface = argv[++i];
+	}
+
+	if (!replayPath.empty())
+	{
+		PacketReplay replay;
+		if (!replay.open(replayPath)) {
+			std::cout << "Failed to open capture file " << replayPath << ", or it is not capture format version "
+				<< PacketCaptureFormat::Version << std::endl;
+			return 1;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		uint64_t count = replay.run(fast ? PacketReplay::MaxSpeed : PacketReplay::RealTime);
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << "Replayed " << count << " datagrams in " << seconds << " s" << std::endl;
+		return 0;
+	}
+
+	UdpServer udpServer(hostDestinationAddress, (uint16_t)port, nullptr, capturePath, DatagramFilter(), multicastInterface);
+	udpServer.setDrainToLatest(latest);
+	udpServer.setSpin(spinUs);
+	if (busyPollUs && !udpServer.setBusyPoll(busyPollUs))
+		std::cout << "SO_BUSY_POLL was not accepted" << std::endl;
+	if (!scheduling.isDefault())
+		std::cout << "Receive thread: " << udpServer.setThreadScheduling(scheduling) << std::endl;
 
-	while (!_kbhit())
-		XsTime::msleep(10);
+	std::cout << "Press enter to quit" << std::endl;
+	std::cin.get();
 
 	return 0;
 }
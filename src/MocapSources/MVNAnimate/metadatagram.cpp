@@ -34,6 +34,7 @@
 /*! Construct a meta data datagram */
 MetaDatagram::MetaDatagram()
 	: Datagram()
+	, m_itemsParsed(true)
 {
 	setType(SPMetaMoreMeta);
 	setDataCount(1);
@@ -52,10 +53,11 @@ MetaDatagram::~MetaDatagram()
 */
 std::string MetaDatagram::itemData(const std::string &itemName) const
 {
-	if(hasItem(itemName))
+	auto item = items().find(itemName);
+	if (item != items().end())
 	{
 		//element found;
-		return m_items.find(itemName)->second;
+		return item->second;
 	}
 	return std::string();
 }
@@ -65,10 +67,18 @@ std::string MetaDatagram::itemData(const std::string &itemName) const
 */
 bool MetaDatagram::hasItem(const std::string &itemName) const
 {
-	return m_items.find(itemName) != m_items.end();
+	return items().find(itemName) != items().end();
 }
 
-/*! Deserialize the data */
+/*! Deserialize the data
+
+	Only the string is kept, the items are split out of it the first time one is asked for. A
+	pooled datagram carries the meta data of every avatar in turn, so a receiver that already
+	knows an avatar's string can compare content() and never pay for the parse.
+
+	A negative or overlong string size fails the streamer, so the datagram is dropped, and clears
+	the string so nothing of the previous avatar's meta data is left in this instance.
+*/
 void MetaDatagram::deserializeData(Streamer &inputStreamer)
 {
 	Streamer* streamer = &inputStreamer;
@@ -76,40 +86,50 @@ void MetaDatagram::deserializeData(Streamer &inputStreamer)
 	int stringSize = 0;
 	streamer->read(stringSize);
 
-	std::string in;
-	streamer->read(in, stringSize);
+	const uint8_t* text = nullptr;
+	if (stringSize < 0 || !streamer->readBlock(text, (size_t)stringSize)) {
+		streamer->fail();
+		m_content.clear();
+		m_items.clear();
+		m_itemsParsed = true;
+		return;
+	}
 
-	std::map<std::string, std::string> out;
+	std::string_view content((const char*)text, (size_t)stringSize);
+	if (content == m_content)
+		return;
 
-	// split string
-	std::vector<std::string> input = split(in, '\n');
+	m_content.assign(content.data(), content.size());
+	m_itemsParsed = false;
+}
+
+/*! The "tagname:tagdata" items of the string, one per line, split out on first use */
+const std::map<std::string, std::string>& MetaDatagram::items() const
+{
+	if (m_itemsParsed)
+		return m_items;
 
-	for (int i=0; i < input.size(); i++)
+	m_items.clear();
+	m_itemsParsed = true;
+
+	std::string_view content = m_content;
+
+	while (!content.empty())
 	{
-		std::string &item = input.at(i);
-		std::vector<std::string> keyvalue = split(item, ':');
-		std::string key, value;
+		size_t end = content.find('\n');
+		std::string_view line = content.substr(0, end);
+		content = (end == std::string_view::npos) ? std::string_view() : content.substr(end + 1);
 
-		if (keyvalue.size() == 2)
-		{
-			// expected
-			key = keyvalue[0];
-			value = keyvalue[1];
-		}
-		else if (keyvalue.size() > 2)
-		{
-			// apparently someone put some colons in there
-			// how nice of us to take this into account
-			key = keyvalue[0];
-			keyvalue.erase(keyvalue.begin(), keyvalue.begin());
-			value = join(keyvalue,":");
-		}
-		else
+		// anything after the first colon is the value, colons in the value included
+		size_t colon = line.find(':');
+		if (colon == std::string_view::npos)
 			continue; // report error?
 
-		out.insert(std::pair<std::string,std::string>(key, value));
+		std::string_view key = line.substr(0, colon);
+		std::string_view value = line.substr(colon + 1);
+		m_items.emplace(std::string(key), std::string(value));
 	}
-	m_items = out;
+	return m_items;
 }
 
 /*! Return the amount of items in this datagram
@@ -119,7 +139,7 @@ void MetaDatagram::deserializeData(Streamer &inputStreamer)
 */
 int MetaDatagram::itemCount() const
 {
-	return m_items.size();
+	return (int)items().size();
 }
 
 
@@ -145,30 +165,3 @@ void MetaDatagram::printData() const
 		}
 	}
 }
-
-//  Splits the string into substrings wherever sep occurs, and returns the list of those strings.
-std::vector<std::string> MetaDatagram::split(std::string str, char delimiter)
-{
-	std::vector<std::string> internal;
-	std::stringstream ss(str); // Turn the string into a stream.
-	std::string tok;
-
-	while(getline(ss, tok, delimiter))
-		internal.push_back(tok);
-
-	return internal;
-}
-
-
-// Joins all the string list's strings into a single string with each element separated by the given separator
-std::string MetaDatagram::join(std::vector<std::string> strList, char* delimiter)
-{
-	std::string res;
-	for (int i = 0; strList.size(); i++)
-	{
-		res.append(strList.at(i));
-		res.append(delimiter);
-	}
-
-	return res;
-}
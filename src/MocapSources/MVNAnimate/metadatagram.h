@@ -27,6 +27,7 @@
 #ifndef METADATAGRAM_H
 #define METADATAGRAM_H
 
+#include <string_view>
 #include "datagram.h"
 
 class MetaDatagram : public Datagram {
@@ -36,17 +37,22 @@ public:
 
 	virtual void printData() const override;
 
+	std::string itemData(const std::string &itemName) const;
+	bool hasItem(const std::string &itemName) const;
+	int itemCount() const;
+
+	/*! The tagged meta data string as received, valid until the next deserialize */
+	inline std::string_view content() const { return m_content; }
+
 protected:
 	virtual void deserializeData(Streamer &inputStreamer) override;
 
 private:
-	std::map<std::string, std::string> m_items;
-	std::vector<std::string> split(std::string str, char delimiter);
-	std::string MetaDatagram::join(std::vector<std::string> strList, char* delimiter);
+	const std::map<std::string, std::string>& items() const;
 
-	std::string itemData(const std::string &itemName) const;
-	bool hasItem(const std::string &itemName) const;
-	int itemCount() const;
+	std::string m_content;
+	mutable std::map<std::string, std::string> m_items;
+	mutable bool m_itemsParsed;
 };
 
 #endif
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cmath>
+
+/*! Angle and rotation helpers for the MVN datagrams.
+	Euler angles follow the MVN convention: degrees, roll about x, pitch about y and yaw about z,
+	applied in z-y-x order. Quaternions are stored w, x, y, z.
+*/
+namespace MvnMath
+{
+	constexpr double Pi = 3.14159265358979323846;
+
+	constexpr float rad2deg(float radians) { return radians * (float)(180.0 / Pi); }
+	constexpr double deg2rad(double degrees) { return degrees * (Pi / 180.0); }
+
+	inline void quaternionFromEuler(const double euler[3], double quat[4])
+	{
+		double cx = std::cos(deg2rad(euler[0]) / 2), sx = std::sin(deg2rad(euler[0]) / 2);
+		double cy = std::cos(deg2rad(euler[1]) / 2), sy = std::sin(deg2rad(euler[1]) / 2);
+		double cz = std::cos(deg2rad(euler[2]) / 2), sz = std::sin(deg2rad(euler[2]) / 2);
+
+		quat[0] = cx * cy * cz + sx * sy * sz;
+		quat[1] = sx * cy * cz - cx * sy * sz;
+		quat[2] = cx * sy * cz + sx * cy * sz;
+		quat[3] = cx * cy * sz - sx * sy * cz;
+	}
+
+	inline void eulerFromQuaternion(const double quat[4], double euler[3])
+	{
+		double w = quat[0], x = quat[1], y = quat[2], z = quat[3];
+		double sqw = w * w;
+
+		// clamp the pitch sine, rounding can push it just past +-1 at the poles
+		double sinPitch = 2.0 * (x * z - w * y);
+		sinPitch = sinPitch > 1.0 ? 1.0 : (sinPitch < -1.0 ? -1.0 : sinPitch);
+
+		euler[0] = std::atan2(2.0 * (y * z + w * x), 2.0 * (sqw + z * z) - 1.0) * (180.0 / Pi);
+		euler[1] = -std::asin(sinPitch) * (180.0 / Pi);
+		euler[2] = std::atan2(2.0 * (x * y + w * z), 2.0 * (sqw + x * x) - 1.0) * (180.0 / Pi);
+	}
+}
@@ -0,0 +1,328 @@
+#include "packetcapture.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+	: m_data(nullptr)
+	, m_size(0)
+	, m_writable(false)
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+	, m_file(INVALID_HANDLE_VALUE)
+	, m_mapping(nullptr)
+#else
+	, m_file(-1)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close(m_size);
+}
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+
+bool MappedFile::openRead(const std::string& path)
+{
+	close();
+	m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0) {
+		close();
+		return false;
+	}
+
+	m_writable = false;
+	if (!map((size_t)size.QuadPart)) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+bool MappedFile::openWrite(const std::string& path, size_t capacity)
+{
+	close();
+	m_file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE)
+		return false;
+
+	m_writable = true;
+	if (!map(capacity)) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+bool MappedFile::map(size_t size)
+{
+	// A writable mapping larger than the file extends the file to that size
+	DWORD protect = m_writable ? PAGE_READWRITE : PAGE_READONLY;
+	m_mapping = CreateFileMappingA(m_file, nullptr, protect, (DWORD)((uint64_t)size >> 32), (DWORD)(size & 0xFFFFFFFF), nullptr);
+	if (m_mapping == nullptr)
+		return false;
+
+	m_data = (uint8_t*)MapViewOfFile(m_mapping, m_writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size);
+	if (m_data == nullptr) {
+		CloseHandle(m_mapping);
+		m_mapping = nullptr;
+		return false;
+	}
+	m_size = size;
+	return true;
+}
+
+void MappedFile::unmap()
+{
+	if (m_data)
+		UnmapViewOfFile(m_data);
+	if (m_mapping)
+		CloseHandle(m_mapping);
+	m_data = nullptr;
+	m_mapping = nullptr;
+	m_size = 0;
+}
+
+void MappedFile::close(size_t usedSize)
+{
+	unmap();
+	if (m_file != INVALID_HANDLE_VALUE) {
+		if (m_writable) {
+			LARGE_INTEGER end;
+			end.QuadPart = (LONGLONG)usedSize;
+			SetFilePointerEx(m_file, end, nullptr, FILE_BEGIN);
+			SetEndOfFile(m_file);
+		}
+		CloseHandle(m_file);
+	}
+	m_file = INVALID_HANDLE_VALUE;
+	m_writable = false;
+}
+
+#else
+
+bool MappedFile::openRead(const std::string& path)
+{
+	close();
+	m_file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (m_file < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(m_file, &info) != 0 || info.st_size == 0) {
+		close();
+		return false;
+	}
+
+	m_writable = false;
+	if (!map((size_t)info.st_size)) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+bool MappedFile::openWrite(const std::string& path, size_t capacity)
+{
+	close();
+	m_file = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (m_file < 0)
+		return false;
+
+	m_writable = true;
+	if (!map(capacity)) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+bool MappedFile::map(size_t size)
+{
+	if (m_writable && ftruncate(m_file, (off_t)size) != 0)
+		return false;
+
+	void* data = mmap(nullptr, size, m_writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, m_file, 0);
+	if (data == MAP_FAILED)
+		return false;
+
+	m_data = (uint8_t*)data;
+	m_size = size;
+	return true;
+}
+
+void MappedFile::unmap()
+{
+	if (m_data)
+		munmap(m_data, m_size);
+	m_data = nullptr;
+	m_size = 0;
+}
+
+void MappedFile::close(size_t usedSize)
+{
+	unmap();
+	if (m_file >= 0) {
+		if (m_writable && ftruncate(m_file, (off_t)usedSize) != 0)
+			m_writable = false;
+		::close(m_file);
+	}
+	m_file = -1;
+	m_writable = false;
+}
+
+#endif
+
+bool MappedFile::grow(size_t capacity)
+{
+	if (!m_writable || capacity <= m_size)
+		return m_writable;
+	unmap();
+	return map(capacity);
+}
+
+PacketCaptureWriter::PacketCaptureWriter()
+	: m_used(0)
+	, m_count(0)
+{
+}
+
+PacketCaptureWriter::~PacketCaptureWriter()
+{
+	close();
+}
+
+bool PacketCaptureWriter::open(const std::string& path)
+{
+	close();
+	if (!m_file.openWrite(path, GrowSize))
+		return false;
+
+	uint32_t version[2] = { PacketCaptureFormat::Version, 0 };
+	memcpy(m_file.data(), PacketCaptureFormat::Magic, sizeof(PacketCaptureFormat::Magic));
+	memcpy(m_file.data() + PacketCaptureFormat::VersionOffset, version, sizeof(version));
+	m_used = PacketCaptureFormat::HeaderSize;
+	m_count = 0;
+	commit();
+	return true;
+}
+
+void PacketCaptureWriter::close()
+{
+	if (m_file.isOpen())
+		m_file.close(m_used);
+	m_used = 0;
+}
+
+void PacketCaptureWriter::write(const DatagramBatch& batch)
+{
+	for (size_t i = 0; i < batch.count(); i++)
+		write(batch.data(i), batch.size(i), batch.receiveTimeNs(i));
+}
+
+void PacketCaptureWriter::write(const uint8_t* data, size_t size, uint64_t receiveTimeNs)
+{
+	if (!m_file.isOpen())
+		return;
+
+	size_t recordSize = PacketCaptureFormat::paddedSize(size);
+	if (m_used + recordSize > m_file.size() && !m_file.grow(m_file.size() + GrowSize)) {
+		// Out of disk or address space, stop capturing rather than stall the receive thread
+		m_file.close(m_used);
+		return;
+	}
+
+	uint8_t* out = m_file.data() + m_used;
+	uint32_t payloadSize = (uint32_t)size;
+	memcpy(out, &receiveTimeNs, sizeof(receiveTimeNs));
+	memcpy(out + 8, &payloadSize, sizeof(payloadSize));
+	memcpy(out + PacketCaptureFormat::RecordHeaderSize, data, size);
+	memset(out + PacketCaptureFormat::RecordHeaderSize + size, 0, recordSize - PacketCaptureFormat::RecordHeaderSize - size);
+
+	m_used += recordSize;
+	m_count++;
+	commit();
+}
+
+/*! Store the end of the records written so far, a reader never looks past it */
+void PacketCaptureWriter::commit()
+{
+	uint64_t committed = m_used;
+	memcpy(m_file.data() + PacketCaptureFormat::CommittedSizeOffset, &committed, sizeof(committed));
+}
+
+bool PacketCaptureReader::open(const std::string& path)
+{
+	close();
+	if (!m_file.openRead(path))
+		return false;
+
+	uint32_t version = 0;
+	uint64_t committed = 0;
+	if (m_file.size() >= PacketCaptureFormat::HeaderSize
+		&& memcmp(m_file.data(), PacketCaptureFormat::Magic, sizeof(PacketCaptureFormat::Magic)) == 0) {
+		memcpy(&version, m_file.data() + PacketCaptureFormat::VersionOffset, sizeof(version));
+		memcpy(&committed, m_file.data() + PacketCaptureFormat::CommittedSizeOffset, sizeof(committed));
+	}
+
+	if (version != PacketCaptureFormat::Version || committed < PacketCaptureFormat::HeaderSize) {
+		close();
+		return false;
+	}
+
+	// A file cut short after the header was written ends where the data ends
+	m_end = (size_t)std::min<uint64_t>(committed, m_file.size());
+	rewind();
+	return true;
+}
+
+void PacketCaptureReader::close()
+{
+	m_file.close();
+	m_offset = 0;
+	m_end = 0;
+}
+
+void PacketCaptureReader::rewind()
+{
+	m_offset = PacketCaptureFormat::HeaderSize;
+}
+
+bool PacketCaptureReader::next(Record& record)
+{
+	if (!m_file.isOpen() || m_end - m_offset < PacketCaptureFormat::RecordHeaderSize)
+		return false;
+
+	const uint8_t* in = m_file.data() + m_offset;
+	uint32_t payloadSize;
+	memcpy(&record.receiveTimeNs, in, sizeof(record.receiveTimeNs));
+	memcpy(&payloadSize, in + 8, sizeof(payloadSize));
+
+	// The zeroed tail of a file that was never closed, should the committed size be past it
+	if (payloadSize == 0 && record.receiveTimeNs == 0)
+		return false;
+
+	size_t recordSize = PacketCaptureFormat::paddedSize(payloadSize);
+	if (recordSize > m_end - m_offset)
+		return false;
+
+	record.data = in + PacketCaptureFormat::RecordHeaderSize;
+	record.size = payloadSize;
+	m_offset += recordSize;
+	return true;
+}
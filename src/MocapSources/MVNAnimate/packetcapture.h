@@ -0,0 +1,143 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#include "datagrambatch.h"
+
+/*! Layout of a capture file, in host byte order:
+
+	8 bytes magic "MVNCAPTR"
+	4 bytes format version
+	4 bytes reserved, zero
+	8 bytes committed size, the file offset just past the last complete record
+	then per received datagram:
+	8 bytes receive time in nanoseconds, as stamped by the receiver, only the differences are meaningful
+	4 bytes payload size
+	payload bytes, padded with zeros to a multiple of 8
+
+	The writer updates the committed size after every record. The file grows in large zeroed steps,
+	so after a crash the committed size, not the file size, says where the records end.
+
+	Versions:
+	1	one steady_clock stamp per receive batch, shared by every datagram of the batch
+	2	every datagram has its own arrival stamp on the system_clock, from the kernel where it
+		provides one (SO_TIMESTAMPNS), else from the return of the receive call
+
+	Readers only take files of their own version.
+*/
+namespace PacketCaptureFormat
+{
+	static const char Magic[8] = { 'M', 'V', 'N', 'C', 'A', 'P', 'T', 'R' };
+	static const uint32_t Version = 2;
+	static const size_t VersionOffset = sizeof(Magic);
+	static const size_t CommittedSizeOffset = VersionOffset + 2 * sizeof(uint32_t);
+	static const size_t HeaderSize = CommittedSizeOffset + sizeof(uint64_t);
+	static const size_t RecordHeaderSize = 12;
+
+	inline size_t paddedSize(size_t payloadSize) { return (RecordHeaderSize + payloadSize + 7) & ~size_t(7); }
+}
+
+/*! \class MappedFile
+	\brief A file mapped into memory, either read-only or writable and growable
+*/
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(MappedFile const&) = delete;
+	MappedFile& operator=(MappedFile const&) = delete;
+
+	bool openRead(const std::string& path);
+	bool openWrite(const std::string& path, size_t capacity);
+
+	// Remap a writable file with room for at least capacity bytes
+	bool grow(size_t capacity);
+
+	// Unmap, and cut a writable file back to its first usedSize bytes
+	void close(size_t usedSize = 0);
+
+	inline uint8_t* data() const { return m_data; }
+	inline size_t size() const { return m_size; }
+	inline bool isOpen() const { return m_data != nullptr; }
+
+private:
+	bool map(size_t size);
+	void unmap();
+
+	uint8_t* m_data;
+	size_t m_size;
+	bool m_writable;
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+	void* m_file;
+	void* m_mapping;
+#else
+	int m_file;
+#endif
+};
+
+/*! \class PacketCaptureWriter
+	\brief Appends every raw datagram payload and its receive time to a memory-mapped capture file
+
+	Only the receive thread writes, so no locking is done. The file grows in large steps, so the
+	receive loop only pays for a remap every few thousand frames. The committed size in the header
+	is kept current, so a capture cut short by a crash replays up to its last complete record.
+*/
+class PacketCaptureWriter
+{
+public:
+	PacketCaptureWriter();
+	~PacketCaptureWriter();
+
+	bool open(const std::string& path);
+	void close();
+
+	// Store every datagram of batch with its own receive time
+	void write(const DatagramBatch& batch);
+	void write(const uint8_t* data, size_t size, uint64_t receiveTimeNs);
+
+	inline bool isOpen() const { return m_file.isOpen(); }
+	inline uint64_t count() const { return m_count; }
+
+private:
+	static const size_t GrowSize = 64 << 20;
+
+	void commit();
+
+	MappedFile m_file;
+	size_t m_used;
+	uint64_t m_count;
+};
+
+/*! \class PacketCaptureReader
+	\brief Walks the records of a capture file in place, without copying the payloads
+*/
+class PacketCaptureReader
+{
+public:
+	struct Record
+	{
+		uint64_t receiveTimeNs;
+		const uint8_t* data;
+		size_t size;
+	};
+
+	// False if the file is not a capture or was written in another format version
+	bool open(const std::string& path);
+	void close();
+
+	// The next record in receive order, false past the committed records or on a damaged record
+	bool next(Record& record);
+	void rewind();
+
+	inline bool isOpen() const { return m_file.isOpen(); }
+
+private:
+	MappedFile m_file;
+	size_t m_offset = 0;
+	size_t m_end = 0;
+};
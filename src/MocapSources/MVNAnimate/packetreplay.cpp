@@ -0,0 +1,69 @@
+#include "packetreplay.h"
+
+#include <chrono>
+
+PacketReplay::PacketReplay(DatagramCallback data_received_cb, const DatagramFilter& filter)
+	: m_parserManager(new ParserManager(data_received_cb, filter))
+	, m_stopping(false)
+{
+}
+
+PacketReplay::~PacketReplay()
+{
+	stopThread();
+}
+
+bool PacketReplay::open(const std::string& path)
+{
+	return m_reader.open(path);
+}
+
+uint64_t PacketReplay::run(Mode mode)
+{
+	typedef std::chrono::steady_clock Clock;
+
+	m_reader.rewind();
+
+	uint64_t count = 0;
+	Clock::time_point start = Clock::now();
+	uint64_t firstTimeNs = 0;
+
+	PacketCaptureReader::Record record;
+	while (!m_stopping && m_reader.next(record))
+	{
+		if (mode == RealTime)
+		{
+			if (count == 0)
+				firstTimeNs = record.receiveTimeNs;
+
+			// A stamp before the first one is replayed right away rather than wrapping into a huge wait
+			if (record.receiveTimeNs > firstTimeNs)
+				std::this_thread::sleep_until(start + std::chrono::nanoseconds(record.receiveTimeNs - firstTimeNs));
+		}
+
+		// Stamped as arriving now, so downstream latency covers parsing onwards and not the capture age
+		m_parserManager->readDatagram(record.data, record.size, DatagramBatch::nowNs());
+		count++;
+	}
+	return count;
+}
+
+void PacketReplay::startThread(Mode mode, bool loop)
+{
+	stopThread();
+	m_stopping = false;
+	m_thread = std::thread([this, mode, loop]() {
+		do {
+			// an empty capture would otherwise spin
+			if (run(mode) == 0)
+				break;
+		} while (loop && !m_stopping);
+	});
+}
+
+void PacketReplay::stopThread()
+{
+	m_stopping = true;
+	if (m_thread.joinable())
+		m_thread.join();
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <thread>
+#include <atomic>
+#include <memory>
+
+#include "packetcapture.h"
+#include "parsermanager.h"
+
+/*! \class PacketReplay
+	\brief Feeds a capture file back through ParserManager, as if the datagrams arrived from the network
+
+	RealTime keeps the original gaps between datagrams, so the driver sees the recorded session
+	exactly as it was streamed. MaxSpeed parses back to back, for measuring parser and pipeline
+	throughput. Replaying the same file always hands the same payloads to the parser in the same order.
+*/
+class PacketReplay
+{
+public:
+	enum Mode
+	{
+		RealTime,
+		MaxSpeed
+	};
+
+	PacketReplay(DatagramCallback data_received_cb = nullptr, const DatagramFilter& filter = DatagramFilter());
+	~PacketReplay();
+
+	bool open(const std::string& path);
+
+	// Replay on the calling thread, once through the file. Returns the number of datagrams replayed.
+	uint64_t run(Mode mode);
+
+	// Replay on a background thread, from the start again whenever the end is reached if loop is set
+	void startThread(Mode mode, bool loop);
+	void stopThread();
+
+private:
+	PacketCaptureReader m_reader;
+	std::unique_ptr<ParserManager> m_parserManager;
+	std::thread m_thread;
+	std::atomic_bool m_stopping;
+};
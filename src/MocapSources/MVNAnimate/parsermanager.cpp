@@ -26,6 +26,8 @@
 
 #include "parsermanager.h"
 
+#include <cstring>
+
 #include "eulerdatagram.h"
 #include "scaledatagram.h"
 #include "metadatagram.h"
@@ -37,14 +39,28 @@
 #include "positiondatagram.h"
 #include "timecodedatagram.h"
 #include "trackerkinematicsdatagram.h"
+#include "unity3ddatagram.h"
 
 
-ParserManager::ParserManager() : m_datagram_cb(nullptr)
+ParserManager::ParserManager()
+	: m_datagram_cb(nullptr)
+	, m_filteredCount(0)
+	, m_unhandledCount(0)
+	, m_pendingHeaders(DatagramBatch::MaxDatagrams)
+	, m_staleCount(0)
 {
+	createPools();
 }
 
-ParserManager::ParserManager(DatagramCallback datagram_cb) : m_datagram_cb(datagram_cb)
+ParserManager::ParserManager(DatagramCallback datagram_cb, const DatagramFilter& filter)
+	: m_datagram_cb(datagram_cb)
+	, m_filter(filter)
+	, m_filteredCount(0)
+	, m_unhandledCount(0)
+	, m_pendingHeaders(DatagramBatch::MaxDatagrams)
+	, m_staleCount(0)
 {
+	createPools();
 }
 
 /*! Destructor */
@@ -52,46 +68,227 @@ ParserManager::~ParserManager()
 {
 }
 
-Datagram* ParserManager::createDgram(StreamingProtocol proto)
+/*! Construct every datagram up front, so parsing a packet never allocates one */
+void ParserManager::createPools()
 {
-	switch (proto)
+	m_pools.clear();
+	m_pools.resize(SPTimeCode + 1);
+
+	m_pools[SPPoseEuler].populate<EulerDatagram>(PoolSize);
+	m_pools[SPPoseQuaternion].populate<QuaternionDatagram>(PoolSize);
+	m_pools[SPPosePositions].populate<PositionDatagram>(PoolSize);
+	m_pools[SPPoseUnity3D].populate<Unity3DDatagram>(PoolSize);
+	m_pools[SPMetaScaling].populate<ScaleDatagram>(PoolSize);
+	m_pools[SPMetaMoreMeta].populate<MetaDatagram>(PoolSize);
+	m_pools[SPJointAngles].populate<JointAnglesDatagram>(PoolSize);
+	m_pools[SPLinearSegmentKinematics].populate<LinearSegmentKinematicsDatagram>(PoolSize);
+	m_pools[SPAngularSegmentKinematics].populate<AngularSegmentKinematicsDatagram>(PoolSize);
+	m_pools[SPTrackerKinematics].populate<TrackerKinematicsDatagram>(PoolSize);
+	m_pools[SPCenterOfMass].populate<CenterOfMassDatagram>(PoolSize);
+	m_pools[SPTimeCode].populate<TimeCodeDatagram>(PoolSize);
+
+	for (int proto = 0; proto < (int)m_pools.size() && proto < SPProtocolCount; proto++)
 	{
-	case SPPoseEuler:		return new EulerDatagram;
-	case SPPoseQuaternion:	return new QuaternionDatagram;
-	case SPPosePositions:	return new PositionDatagram;
-	case SPMetaScaling:		return new ScaleDatagram;
-	case SPMetaMoreMeta:	return new MetaDatagram;
-	case SPJointAngles:					return new JointAnglesDatagram;
-	case SPLinearSegmentKinematics:		return new LinearSegmentKinematicsDatagram;
-	case SPAngularSegmentKinematics:	return new AngularSegmentKinematicsDatagram;
-	case SPTrackerKinematics:			return new TrackerKinematicsDatagram;
-	case SPCenterOfMass:				return new CenterOfMassDatagram;
-	case SPTimeCode:					return new TimeCodeDatagram;
-
-	default:
-		return nullptr;
+		if (m_filter.rawRecords.test(proto))
+			m_pools[proto].forEach([](Datagram* datagram) { datagram->setDecodeRecords(false); });
 	}
+
+	if (m_filter.segments.empty())
+		return;
+	for (DatagramPool& datagrams : m_pools)
+		datagrams.forEach([this](Datagram* datagram) { datagram->setSegmentFilter(&m_filter.segments); });
+}
+
+/*! The pool holding datagrams of \a proto, or nullptr if the protocol has no parser */
+DatagramPool* ParserManager::pool(StreamingProtocol proto)
+{
+	if (proto <= SPUnknown || proto >= (int)m_pools.size() || !m_pools[proto].capacity())
+		return nullptr;
+	return &m_pools[proto];
 }
 
 /*! Read single datagram from the incoming stream */
-void ParserManager::readDatagram(const XsByteArray &data)
+void ParserManager::readDatagram(const ByteArray &data)
+{
+	readDatagram(data.data(), data.size());
+}
+
+/*! Read a single datagram in place from a raw receive buffer that arrived at \a receiveTimeNs */
+void ParserManager::readDatagram(const uint8_t* data, size_t size, uint64_t receiveTimeNs)
+{
+	// The header is decoded once here and handed to the datagram, so it is not parsed twice
+	DatagramHeader header;
+	if (!DatagramHeader::parse(data, size, header))
+	{
+		m_unhandledCount++;
+		if (m_filter.print)
+			std::cout << "Unhandled datagram: " << std::string((const char*)data, size) << std::endl;
+		return;
+	}
+
+	// Protocols nobody consumes go no further than the header
+	if (header.protocol < SPProtocolCount && !m_filter.protocols.test(header.protocol))
+	{
+		m_filteredCount++;
+		return;
+	}
+
+	// A counter of 0x80 means the whole sample fit in this one datagram, the usual case
+	if (header.datagramCounter == 0x80)
+	{
+		parseSample(header, data, size, receiveTimeNs);
+		return;
+	}
+
+	// A split sample is usable from the moment its last fragment arrives
+	if (m_assembler.add(header, data, size))
+		parseSample(m_assembler.header(), m_assembler.data(), m_assembler.size(), receiveTimeNs);
+}
+
+/*! Parse a packet holding one complete sample and hand it to the callback */
+void ParserManager::parseSample(const DatagramHeader& header, const uint8_t* data, size_t size, uint64_t receiveTimeNs)
 {
-	StreamingProtocol type = static_cast<StreamingProtocol>(Datagram::messageType(data));
-	Datagram *datagram = createDgram(type);
+	StreamingProtocol type = static_cast<StreamingProtocol>(header.protocol);
+	DatagramPool* datagrams = pool(type);
+	Datagram *datagram = datagrams ? datagrams->acquire() : nullptr;
 
 	if (datagram != nullptr)
 	{
-		datagram->deserialize(data);
-		// note that this can cause a lot of console spam
-		datagram->printHeader();
-		datagram->printData();
-		if (m_datagram_cb) {
-			m_datagram_cb(type, datagram);
+		if (datagram->deserialize(header, data, size))
+		{
+			datagram->setReceiveTimeNs(receiveTimeNs);
+
+			// note that this can cause a lot of console spam
+			if (m_filter.print) {
+				datagram->printHeader();
+				datagram->printData();
+			}
+			if (m_datagram_cb) {
+				m_datagram_cb(type, datagram);
+			}
+		}
+		else
+		{
+			m_unhandledCount++;
+			if (m_filter.print)
+				std::cout << "Truncated datagram: " << size << " bytes" << std::endl;
 		}
+		datagrams->release(datagram);
 	}
 	else
 	{
-		XsString str(data.size(), (const char*)data.data());
-		std::cout << "Unhandled datagram: " << str.c_str() << std::endl;
+		m_unhandledCount++;
+		if (m_filter.print)
+			std::cout << "Unhandled datagram: " << std::string((const char*)data, size) << std::endl;
+	}
+}
+
+/*! Read every datagram of a received batch, in arrival order */
+void ParserManager::readBatch(const DatagramBatch& batch)
+{
+	for (size_t i = 0; i < batch.count(); i++)
+		readDatagram(batch.data(i), batch.size(i), batch.receiveTimeNs(i));
+}
+
+/*! Parse the meta data of \a batch now and keep only the newest complete sample of every avatar,
+	and anything newer, for flushLatest()
+*/
+void ParserManager::collectLatest(const DatagramBatch& batch)
+{
+	DatagramHeader header;
+	for (size_t i = 0; i < batch.count(); i++)
+	{
+		if (!DatagramHeader::parse(batch.data(i), batch.size(i), header)
+			|| header.protocol == SPMetaMoreMeta || header.protocol == SPMetaScaling
+			|| header.protocol >= SPProtocolCount || !m_filter.protocols.test(header.protocol))
+		{
+			readDatagram(batch.data(i), batch.size(i), batch.receiveTimeNs(i));
+			continue;
+		}
+		collectLatest(header, batch.data(i), batch.size(i), batch.receiveTimeNs(i));
+	}
+}
+
+void ParserManager::collectLatest(const DatagramHeader& header, const uint8_t* data, size_t size, uint64_t receiveTimeNs)
+{
+	int avatar = header.avatarId;
+
+	if (m_hasComplete.test(avatar) && header.sampleCounter < m_completeSample[avatar])
+	{
+		m_staleCount++;
+		return;
+	}
+
+	// Out of room, which takes a lot of avatars and protocols, so parse what is pending now
+	if (m_pending.count() == DatagramBatch::MaxDatagrams)
+		flushLatest();
+
+	size_t slot = m_pending.count();
+	memcpy(m_pending.slot(slot), data, size);
+	m_pending.setSize(slot, size);
+	m_pending.setReceiveTime(slot, receiveTimeNs);
+	m_pendingHeaders[slot] = header;
+	m_pending.setCount(slot + 1);
+
+	// Older samples of the avatar only become stale once this one is whole, so a sample whose
+	// last fragment is still on the way never pushes out the newest one that can be published
+	if (!isSampleComplete(avatar, header.sampleCounter))
+		return;
+
+	for (size_t i = 0; i < m_pending.count(); i++)
+	{
+		if (m_pending.size(i) && m_pendingHeaders[i].avatarId == avatar && m_pendingHeaders[i].sampleCounter < header.sampleCounter) {
+			m_pending.setSize(i, 0);
+			m_staleCount++;
+		}
+	}
+	m_completeSample[avatar] = header.sampleCounter;
+	m_hasComplete.set(avatar);
+}
+
+/*! Whether every protocol of the pending sample has all its fragments up to the one with the 0x80 bit */
+bool ParserManager::isSampleComplete(int avatar, int32_t sampleCounter) const
+{
+	uint32_t received[SPProtocolCount] = {};
+	int lastIndex[SPProtocolCount];
+	for (int protocol = 0; protocol < SPProtocolCount; protocol++)
+		lastIndex[protocol] = -1;
+
+	for (size_t i = 0; i < m_pending.count(); i++)
+	{
+		const DatagramHeader& header = m_pendingHeaders[i];
+		if (!m_pending.size(i) || header.avatarId != avatar || header.sampleCounter != sampleCounter)
+			continue;
+
+		size_t index = header.datagramCounter & 0x7F;
+		if (index >= SampleAssembler::MaxFragments)
+			continue;
+		received[header.protocol] |= 1u << index;
+		if (header.datagramCounter & 0x80)
+			lastIndex[header.protocol] = (int)index;
+	}
+
+	bool any = false;
+	for (int protocol = 0; protocol < SPProtocolCount; protocol++)
+	{
+		if (!received[protocol])
+			continue;
+		uint32_t needed = lastIndex[protocol] < 0 ? 0 : (2u << lastIndex[protocol]) - 1;
+		if (lastIndex[protocol] < 0 || (received[protocol] & needed) != needed)
+			return false;
+		any = true;
+	}
+	return any;
+}
+
+/*! Parse every datagram collectLatest() kept, and start over */
+void ParserManager::flushLatest()
+{
+	for (size_t i = 0; i < m_pending.count(); i++)
+	{
+		if (m_pending.size(i))
+			readDatagram(m_pending.data(i), m_pending.size(i), m_pending.receiveTimeNs(i));
 	}
+	m_pending.clear();
+	m_hasComplete.reset();
 }
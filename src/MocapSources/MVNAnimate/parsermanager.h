@@ -27,24 +27,83 @@
 #ifndef PARSERMANAGER_H
 #define PARSERMANAGER_H
 
-#include <functional>
+#include <bitset>
 #include "datagram.h"
+#include "datagrambatch.h"
+#include "datagramdispatch.h"
+#include "datagrampool.h"
+#include "sampleassembler.h"
 
-typedef std::function<void(StreamingProtocol, const Datagram*)> DatagramCallback;
-//typedef void (*DatagramCallback)(StreamingProtocol, const Datagram*);
+/*! \struct DatagramFilter
+	\brief Which datagrams a ParserManager decodes, and whether it prints them
+
+	Datagrams of a protocol outside \a protocols are dropped after peeking at their header, before
+	reassembly or decoding. Datagrams made of segment records decode only the IDs in \a segments,
+	or every segment while it is empty. Those of a protocol in \a rawRecords are not decoded at all,
+	their consumer reads the records straight from the packet with forEachRecord(). The default
+	decodes and prints everything.
+*/
+struct DatagramFilter
+{
+	std::bitset<SPProtocolCount> protocols;
+	SegmentIdMask segments;
+	std::bitset<SPProtocolCount> rawRecords;
+	bool print;
+
+	DatagramFilter() : print(true) { protocols.set(); }
+};
 
 class ParserManager
 {
 public:
 	ParserManager();
-	ParserManager(DatagramCallback datagram_cb);
+	ParserManager(DatagramCallback datagram_cb, const DatagramFilter& filter = DatagramFilter());
 	~ParserManager();
-	void readDatagram(const XsByteArray &data);
+	void readDatagram(const ByteArray &data);
+	void readDatagram(const uint8_t* data, size_t size, uint64_t receiveTimeNs = 0);
+	void readBatch(const DatagramBatch& batch);
+
+	/*! Drain-to-latest: collect one or more batches with collectLatest(), then flushLatest()
+		parses only the newest complete sample of every avatar among them, and the fragments of any
+		newer sample that is still missing some, in arrival order. A sample is complete once every
+		protocol in it has all fragments up to the one with the 0x80 bit. Meta data and scaling are
+		never stale and are parsed as soon as they are collected.
+	*/
+	void collectLatest(const DatagramBatch& batch);
+	void flushLatest();
+
+	// Datagrams dropped by the protocol filter
+	inline uint64_t filteredCount() const { return m_filteredCount; }
+
+	// Datagrams that were not MXTP, of an unknown type or shorter than their header claims
+	inline uint64_t unhandledCount() const { return m_unhandledCount; }
+
+	// Datagrams skipped by drain-to-latest because a newer complete sample of their avatar was pending
+	inline uint64_t staleCount() const { return m_staleCount; }
 
 private:
-	Datagram* createDgram(StreamingProtocol proto);
+	void createPools();
+	void parseSample(const DatagramHeader& header, const uint8_t* data, size_t size, uint64_t receiveTimeNs);
+	void collectLatest(const DatagramHeader& header, const uint8_t* data, size_t size, uint64_t receiveTimeNs);
+	bool isSampleComplete(int avatar, int32_t sampleCounter) const;
+	DatagramPool* pool(StreamingProtocol proto);
+
+	// Datagrams of one protocol that may be in flight at once
+	static const int PoolSize = 4;
 
 	DatagramCallback m_datagram_cb;
+	DatagramFilter m_filter;
+	uint64_t m_filteredCount;
+	uint64_t m_unhandledCount;
+	std::vector<DatagramPool> m_pools;
+	SampleAssembler m_assembler;
+
+	// Drain-to-latest: copies of the datagrams still in the running, a dropped one has size 0
+	DatagramBatch m_pending;
+	std::vector<DatagramHeader> m_pendingHeaders;
+	int32_t m_completeSample[256];
+	std::bitset<256> m_hasComplete;
+	uint64_t m_staleCount;
 };
 
 #endif
@@ -0,0 +1,73 @@
+#include "poseassembler.h"
+
+#include <algorithm>
+#include <iterator>
+
+PoseAssembler::PoseAssembler()
+	: m_requiredParts(0)
+	, m_evicted(0)
+	, m_rejected(0)
+{
+	for (Slot& slot : m_slots)
+		slot.used = false;
+}
+
+void PoseAssembler::reset(uint32_t requiredParts)
+{
+	m_requiredParts = requiredParts;
+	for (Slot& slot : m_slots)
+		slot.used = false;
+}
+
+PoseSample* PoseAssembler::acquire(int32_t sampleCounter)
+{
+	Clock::time_point now = Clock::now();
+	evictExpired(now);
+
+	Slot& target = slot(sampleCounter);
+	if (target.used && target.sampleCounter == sampleCounter)
+		return &target.pose;
+
+	if (target.used && target.sampleCounter > sampleCounter) {
+		m_rejected++;
+		return nullptr;
+	}
+
+	// An older sample still waiting for its other parts loses its slot
+	if (target.used)
+		m_evicted++;
+
+	target.used = true;
+	target.sampleCounter = sampleCounter;
+	target.parts = 0;
+	target.started = now;
+	target.pose.pose_id = sampleCounter;
+	target.pose.receive_time_ns = 0;
+	std::fill(std::begin(target.pose.valid), std::end(target.pose.valid), 0);
+	return &target.pose;
+}
+
+bool PoseAssembler::complete(int32_t sampleCounter, uint32_t part)
+{
+	Slot& target = slot(sampleCounter);
+	if (!target.used || target.sampleCounter != sampleCounter)
+		return false;
+
+	target.parts |= part;
+	if ((target.parts & m_requiredParts) != m_requiredParts)
+		return false;
+
+	target.used = false;
+	return true;
+}
+
+void PoseAssembler::evictExpired(Clock::time_point now)
+{
+	for (Slot& slot : m_slots)
+	{
+		if (slot.used && now - slot.started > Deadline) {
+			slot.used = false;
+			m_evicted++;
+		}
+	}
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+
+#include <IMocapStreamSource.hpp>
+
+/*! \class PoseAssembler
+	\brief Collects the parts of one avatar's pose that arrive in separate packets
+
+	A pose can be made of several protocols of the same sample, e.g. segment transforms from one
+	packet and velocities from another. Each sample is assembled in the slot sampleCounter %
+	SlotCount, tagged with its sample counter, and every packet that fills part of it sets its bit
+	in the slot's mask. The pose is complete once the mask covers every required part.
+
+	The slots and their fixed size poses are part of the assembler, so collecting a pose never
+	touches the heap and takes constant time. A sample whose parts do not all arrive within the deadline is
+	dropped, as is one whose slot is needed by a sample SlotCount newer. Packets of a sample older
+	than the one in its slot are too late and are rejected.
+*/
+class PoseAssembler
+{
+public:
+	// A power of two, so the slot index survives the sample counter going negative
+	static constexpr size_t SlotCount = 8;
+
+	// Partial poses older than this are evicted, a few frames at 240 Hz
+	static constexpr std::chrono::milliseconds Deadline{ 50 };
+
+	PoseAssembler();
+
+	PoseAssembler(PoseAssembler const&) = delete;
+	PoseAssembler& operator=(PoseAssembler const&) = delete;
+
+	/*! Assemble poses that are complete once every part in \a requiredParts has arrived. Drops
+		anything pending.
+	*/
+	void reset(uint32_t requiredParts);
+
+	/*! The pose being assembled for \a sampleCounter, in a fresh slot with no valid segments for a
+		new sample. nullptr if the packet is too late for its sample.
+	*/
+	PoseSample* acquire(int32_t sampleCounter);
+
+	/*! Record that \a part of \a sampleCounter was written to its pose. Returns true when that
+		made the pose complete. It stays readable until the next acquire().
+	*/
+	bool complete(int32_t sampleCounter, uint32_t part);
+
+	inline uint64_t evictedCount() const { return m_evicted; }
+	inline uint64_t rejectedCount() const { return m_rejected; }
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Slot
+	{
+		bool used;
+		int32_t sampleCounter;		// generation tag
+		uint32_t parts;				// bit per part written so far
+		Clock::time_point started;
+		PoseSample pose;
+	};
+
+	inline Slot& slot(int32_t sampleCounter) { return m_slots[(uint32_t)sampleCounter % SlotCount]; }
+	void evictExpired(Clock::time_point now);
+
+	Slot m_slots[SlotCount];
+	uint32_t m_requiredParts;
+
+	uint64_t m_evicted;
+	uint64_t m_rejected;
+};
@@ -47,6 +47,7 @@ PositionDatagram::PositionDatagram()
 	: Datagram()
 {
 	setType(SPPosePositions);
+	m_data.reserve(MaxDataCount);
 }
 
 /*! Destructor */
@@ -61,6 +62,9 @@ void PositionDatagram::deserializeData(Streamer &inputStreamer)
 {
 	Streamer* streamer = &inputStreamer;
 
+	// Pooled instances are reused, drop the previous packet without releasing capacity
+	m_data.clear();
+
 	for (int i = 0; i < dataCount(); i++)
 	{
 		VirtualMarkerSet marker;
@@ -70,14 +74,16 @@ void PositionDatagram::deserializeData(Streamer &inputStreamer)
 
 		// Store the Point Position in a Vector -> 12 byte	(3 x 4 byte)
 		// The coordinates use a Y-Up, right-handed coordinate system.
-		for (int k = 0; k < 3; k++)
-			streamer->read(marker.pointPos[k]);
+		streamer->read(marker.pointPos, 3);
 
 		for (int k = 0; k < 3; k++)
 			marker.pointPos[k] /= EULERPOSITIONSCALE;
 
 		convertFromYupToZup(marker.pointPos);
 
+		if (!streamer->ok())
+			break;
+
 		m_data.push_back(marker);
 	}
 }
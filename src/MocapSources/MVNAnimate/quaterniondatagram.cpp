@@ -25,7 +25,7 @@
 */
 
 #include "quaterniondatagram.h"
-#include <xstypes/xsmath.h>
+#include "mvnmath.h"
 
 /*! \class QuaternionDatagram
   \brief a Position & Quaternion orientation pose datagram (type 02)
@@ -49,6 +49,8 @@
 /*! Constructor */
 QuaternionDatagram::QuaternionDatagram()
 	: Datagram()
+	, m_wire(nullptr)
+	, m_wireCount(0)
 {
 	setType(SPPoseQuaternion);
 }
@@ -59,47 +61,57 @@ QuaternionDatagram::~QuaternionDatagram()
 
 }
 
+/*! Gather the record at \a index from the decoded columns */
+QuaternionDatagram::Kinematics QuaternionDatagram::record(size_t index) const
+{
+	Kinematics kin;
+	kin.segmentId = m_records.segmentId[index];
+	for (int k = 0; k < 3; k++)
+		kin.position[k] = m_records.column(1 + k)[index];
+	for (int k = 0; k < 4; k++)
+		kin.orientation[k] = m_records.column(4 + k)[index];
+	return kin;
+}
+
 /*! Deserialize the data from \a arr
 	\sa serializeData
 */
 QuaternionDatagram::Kinematics QuaternionDatagram::GetSegmentData(Segment segmentIndex) const
 {
 	// ID is index + 1 accoring to https://www.xsens.com/hubfs/Downloads/Manuals/MVN_real-time_network_streaming_protocol_specification.pdf
-	int segmentID = segmentIndex + 1; 
-	auto segment_it = std::find_if(m_data.begin(), m_data.end(), [&segmentID](const Kinematics& arg) {
-		return arg.segmentId == segmentID;
-	});
-	if (segment_it != m_data.end()) {
-		return *segment_it;
-	}
-	return Kinematics{-1};
+	int index = m_records.find(segmentIndex + 1);
+	if (index < 0)
+		return Kinematics{-1};
+	return record(index);
 }
 
 void QuaternionDatagram::deserializeData(Streamer &inputStreamer)
 {
 	Streamer* streamer = &inputStreamer;
 
-	for (int i = 0; i < dataCount(); i++)
-	{
-		Kinematics kin;
-
-		// 4 byte
-		streamer->read(kin.segmentId);
-
-		// Store the Sensor Position in a Vector -> 12 byte	(3 x 4 byte)
-		// The coordinates use a Z-Up, right-handed coordinate system.
-		for (int k = 0; k < 3; k++)
-			streamer->read(kin.position[k]);
-
-		// Store the Quaternion Rotation in a vector -> 16 byte	(4 x 4 byte)
-		for (int k = 0; k < 4; k++)
-			streamer->read(kin.orientation[k]);
+	// Every item is a fixed 32 byte record, so the array is decoded in one go (or just the filtered segments)
+	const uint8_t* records = nullptr;
+	if (!streamer->readBlock(records, dataCount() * m_records.RecordSize)) {
+		m_records.clear();
+		m_wireCount = 0;
+		return;
+	}
+	m_wire = records;
+	m_wireCount = dataCount();
 
-		// trasform in degrees
-		for (int k = 0; k < 4; k++)
-			kin.orientation[k] = XsMath_rad2deg(kin.orientation[k]);
+	// A consumer reading the records with forEachRecord does not need the columns
+	if (!decodeRecords()) {
+		m_records.clear();
+		return;
+	}
+	RecordDecoder::decode(records, dataCount(), segmentFilter(), m_records);
 
-		m_data.push_back(kin);
+	// trasform in degrees
+	for (size_t field = 4; field <= 7; field++)
+	{
+		float* values = m_records.column(field);
+		for (size_t i = 0; i < m_records.count; i++)
+			values[i] = MvnMath::rad2deg(values[i]);
 	}
 }
 
@@ -112,28 +124,30 @@ void QuaternionDatagram::printData() const
 	const int leftHandSegmentMax = propSegmentMax + fingerTrackingSegmentCount()/2;
 	//const int rightHandSegmentMax = leftHandSegmentMax + fingerTrackingSegmentCount()/2;
 
-	for (int i = 0; i < m_data.size(); i++)
+	for (size_t i = 0; i < m_records.count; i++)
 	{
+		const Kinematics kin = record(i);
+
 		if (i < bodySegmentMax)
-			std::cout << "Body Segment (ID): " << m_data.at(i).segmentId << std::endl;
+			std::cout << "Body Segment (ID): " << kin.segmentId << std::endl;
 		else if (i < propSegmentMax)
-			std::cout << "Prop Segment (ID): " << m_data.at(i).segmentId << std::endl;
+			std::cout << "Prop Segment (ID): " << kin.segmentId << std::endl;
 		else if (i < leftHandSegmentMax)
-			std::cout << "Left Hand Segment (ID): " << m_data.at(i).segmentId - propSegmentMax << std::endl;
+			std::cout << "Left Hand Segment (ID): " << kin.segmentId - propSegmentMax << std::endl;
 		else
-			std::cout << "Right Hand Segment (ID): " << m_data.at(i).segmentId - leftHandSegmentMax << std::endl;
+			std::cout << "Right Hand Segment (ID): " << kin.segmentId - leftHandSegmentMax << std::endl;
 
 		// Position
 		std::cout << "Segment Position: " << "(";
-		std::cout << "x: " << m_data.at(i).position[0] << ", ";
-		std::cout << "y: " << m_data.at(i).position[1] << ", ";
-		std::cout << "z: " << m_data.at(i).position[2] << ")"<< std::endl;
+		std::cout << "x: " << kin.position[0] << ", ";
+		std::cout << "y: " << kin.position[1] << ", ";
+		std::cout << "z: " << kin.position[2] << ")"<< std::endl;
 
 		// Quaternion Orientation
 		std::cout << "Quaternion Orientation: " << "(";
-		std::cout << "re: " << m_data.at(i).orientation[0] << ", ";
-		std::cout << "i: " << m_data.at(i).orientation[1] << ", ";
-		std::cout << "j: " << m_data.at(i).orientation[2] << ", ";
-		std::cout << "k: " << m_data.at(i).orientation[3] << ")"<< std::endl << std::endl;
+		std::cout << "re: " << kin.orientation[0] << ", ";
+		std::cout << "i: " << kin.orientation[1] << ", ";
+		std::cout << "j: " << kin.orientation[2] << ", ";
+		std::cout << "k: " << kin.orientation[3] << ")"<< std::endl << std::endl;
 	}
 }
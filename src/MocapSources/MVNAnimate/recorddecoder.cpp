@@ -0,0 +1,264 @@
+#include "recorddecoder.h"
+#include "streamer.h"
+
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define RECORDDECODER_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC always allows intrinsics, GCC and Clang need the ISA enabled per function
+#if defined(_MSC_VER)
+#define RECORDDECODER_TARGET(isa)
+#else
+#define RECORDDECODER_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+typedef void (*SwapWordsFunction)(const uint8_t* src, uint32_t* dst, size_t count);
+
+// Records [firstRecord, records) of fieldCount words each, see RecordDecoder::transposeWords
+typedef void (*TransposeWordsFunction)(const uint8_t* src, size_t firstRecord, size_t records, size_t fieldCount, void* const* columns);
+
+static void swapWordsScalar(const uint8_t* src, uint32_t* dst, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		dst[i] = WireOrder::load<uint32_t>(src + i * sizeof(uint32_t));
+}
+
+// Fields [firstField, lastField) of records [firstRecord, records), one word at a time
+static void transposeWordRange(const uint8_t* src, size_t firstRecord, size_t records, size_t firstField, size_t lastField,
+	size_t fieldCount, void* const* columns)
+{
+	for (size_t f = firstField; f < lastField; f++)
+	{
+		uint32_t* column = static_cast<uint32_t*>(columns[f]);
+		for (size_t r = firstRecord; r < records; r++)
+		{
+			uint32_t word = WireOrder::load<uint32_t>(src + (r * fieldCount + f) * sizeof(uint32_t));
+			memcpy(column + r, &word, sizeof(word));
+		}
+	}
+}
+
+static void transposeWordsScalar(const uint8_t* src, size_t firstRecord, size_t records, size_t fieldCount, void* const* columns)
+{
+	transposeWordRange(src, firstRecord, records, 0, fieldCount, fieldCount, columns);
+}
+
+#if defined(RECORDDECODER_X86)
+
+RECORDDECODER_TARGET("ssse3")
+static void swapWordsSSSE3(const uint8_t* src, uint32_t* dst, size_t count)
+{
+	const __m128i reverse = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * sizeof(uint32_t)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(words, reverse));
+	}
+	swapWordsScalar(src + i * sizeof(uint32_t), dst + i, count - i);
+}
+
+/*! Four records at a time: every group of four fields is loaded as four rows, swapped and
+	transposed into four columns in registers. Fields past the last whole group and the records
+	past the last whole block of four are done one word at a time.
+*/
+RECORDDECODER_TARGET("ssse3")
+static void transposeWordsSSSE3(const uint8_t* src, size_t firstRecord, size_t records, size_t fieldCount, void* const* columns)
+{
+	const __m128i reverse = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+	const size_t recordSize = fieldCount * sizeof(uint32_t);
+	const size_t wholeFields = fieldCount & ~(size_t)3;
+
+	size_t r = firstRecord;
+	for (; r + 4 <= records; r += 4)
+	{
+		const uint8_t* block = src + r * recordSize;
+		for (size_t f = 0; f < wholeFields; f += 4)
+		{
+			const uint8_t* row = block + f * sizeof(uint32_t);
+			__m128i a = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row)), reverse);
+			__m128i b = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + recordSize)), reverse);
+			__m128i c = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + 2 * recordSize)), reverse);
+			__m128i d = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + 3 * recordSize)), reverse);
+
+			__m128i ab01 = _mm_unpacklo_epi32(a, b);
+			__m128i cd01 = _mm_unpacklo_epi32(c, d);
+			__m128i ab23 = _mm_unpackhi_epi32(a, b);
+			__m128i cd23 = _mm_unpackhi_epi32(c, d);
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(static_cast<uint32_t*>(columns[f]) + r), _mm_unpacklo_epi64(ab01, cd01));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(static_cast<uint32_t*>(columns[f + 1]) + r), _mm_unpackhi_epi64(ab01, cd01));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(static_cast<uint32_t*>(columns[f + 2]) + r), _mm_unpacklo_epi64(ab23, cd23));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(static_cast<uint32_t*>(columns[f + 3]) + r), _mm_unpackhi_epi64(ab23, cd23));
+		}
+		transposeWordRange(src, r, r + 4, wholeFields, fieldCount, fieldCount, columns);
+	}
+	transposeWordRange(src, r, records, 0, fieldCount, fieldCount, columns);
+}
+
+RECORDDECODER_TARGET("avx2")
+static void swapWordsAVX2(const uint8_t* src, uint32_t* dst, size_t count)
+{
+	// vpshufb shuffles within each 128 bit lane, so both lanes use the same pattern
+	const __m256i reverse = _mm256_set_epi8(
+		12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+		12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256i words = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * sizeof(uint32_t)));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_shuffle_epi8(words, reverse));
+	}
+	swapWordsScalar(src + i * sizeof(uint32_t), dst + i, count - i);
+}
+
+/*! Eight records at a time: every group of eight fields is an 8x8 transpose in registers, the
+	fields past the last whole group are gathered one column at a time. The records past the last
+	whole block of eight go through the SSSE3 kernel.
+*/
+RECORDDECODER_TARGET("avx2")
+static void transposeWordsAVX2(const uint8_t* src, size_t firstRecord, size_t records, size_t fieldCount, void* const* columns)
+{
+	const __m256i reverse = _mm256_set_epi8(
+		12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+		12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+	const size_t recordSize = fieldCount * sizeof(uint32_t);
+	const size_t wholeFields = fieldCount & ~(size_t)7;
+	const int stride = (int)fieldCount;
+	const __m256i rowOffsets = _mm256_setr_epi32(0, stride, 2 * stride, 3 * stride, 4 * stride, 5 * stride, 6 * stride, 7 * stride);
+
+	size_t r = firstRecord;
+	for (; r + 8 <= records; r += 8)
+	{
+		const uint8_t* block = src + r * recordSize;
+		for (size_t f = 0; f < wholeFields; f += 8)
+		{
+			const uint8_t* row = block + f * sizeof(uint32_t);
+			__m256i r0 = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row)), reverse);
+			__m256i r1 = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + recordSize)), reverse);
+			__m256i r2 = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + 2 * recordSize)), reverse);
+			__m256i r3 = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + 3 * recordSize)), reverse);
+			__m256i r4 = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + 4 * recordSize)), reverse);
+			__m256i r5 = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + 5 * recordSize)), reverse);
+			__m256i r6 = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + 6 * recordSize)), reverse);
+			__m256i r7 = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + 7 * recordSize)), reverse);
+
+			// Pairs of rows interleaved, then pairs of pairs: each lane then holds four rows of one field
+			__m256i r01lo = _mm256_unpacklo_epi32(r0, r1), r01hi = _mm256_unpackhi_epi32(r0, r1);
+			__m256i r23lo = _mm256_unpacklo_epi32(r2, r3), r23hi = _mm256_unpackhi_epi32(r2, r3);
+			__m256i r45lo = _mm256_unpacklo_epi32(r4, r5), r45hi = _mm256_unpackhi_epi32(r4, r5);
+			__m256i r67lo = _mm256_unpacklo_epi32(r6, r7), r67hi = _mm256_unpackhi_epi32(r6, r7);
+
+			__m256i f04a = _mm256_unpacklo_epi64(r01lo, r23lo), f15a = _mm256_unpackhi_epi64(r01lo, r23lo);
+			__m256i f26a = _mm256_unpacklo_epi64(r01hi, r23hi), f37a = _mm256_unpackhi_epi64(r01hi, r23hi);
+			__m256i f04b = _mm256_unpacklo_epi64(r45lo, r67lo), f15b = _mm256_unpackhi_epi64(r45lo, r67lo);
+			__m256i f26b = _mm256_unpacklo_epi64(r45hi, r67hi), f37b = _mm256_unpackhi_epi64(r45hi, r67hi);
+
+			// The low lanes hold fields f to f + 3, the high lanes fields f + 4 to f + 7
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(static_cast<uint32_t*>(columns[f + 0]) + r), _mm256_permute2x128_si256(f04a, f04b, 0x20));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(static_cast<uint32_t*>(columns[f + 1]) + r), _mm256_permute2x128_si256(f15a, f15b, 0x20));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(static_cast<uint32_t*>(columns[f + 2]) + r), _mm256_permute2x128_si256(f26a, f26b, 0x20));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(static_cast<uint32_t*>(columns[f + 3]) + r), _mm256_permute2x128_si256(f37a, f37b, 0x20));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(static_cast<uint32_t*>(columns[f + 4]) + r), _mm256_permute2x128_si256(f04a, f04b, 0x31));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(static_cast<uint32_t*>(columns[f + 5]) + r), _mm256_permute2x128_si256(f15a, f15b, 0x31));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(static_cast<uint32_t*>(columns[f + 6]) + r), _mm256_permute2x128_si256(f26a, f26b, 0x31));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(static_cast<uint32_t*>(columns[f + 7]) + r), _mm256_permute2x128_si256(f37a, f37b, 0x31));
+		}
+
+		for (size_t f = wholeFields; f < fieldCount; f++)
+		{
+			__m256i column = _mm256_i32gather_epi32(reinterpret_cast<const int*>(block + f * sizeof(uint32_t)), rowOffsets, 4);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(static_cast<uint32_t*>(columns[f]) + r), _mm256_shuffle_epi8(column, reverse));
+		}
+	}
+
+	// The SSSE3 kernel is SSE encoded, dirty upper halves would stall every instruction in it
+	_mm256_zeroupper();
+	transposeWordsSSSE3(src, r, records, fieldCount, columns);
+}
+
+enum SimdLevel
+{
+	SimdScalar,
+	SimdSSSE3,
+	SimdAVX2
+};
+
+static SimdLevel detectSimdLevel()
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	bool ssse3 = (info[2] & (1 << 9)) != 0;
+	bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+
+	bool avx2 = false;
+	if (maxLeaf >= 7 && osSavesYmm) {
+		__cpuidex(info, 7, 0);
+		avx2 = (info[1] & (1 << 5)) != 0;
+	}
+
+	if (avx2)
+		return SimdAVX2;
+	if (ssse3)
+		return SimdSSSE3;
+#else
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return SimdAVX2;
+	if (__builtin_cpu_supports("ssse3"))
+		return SimdSSSE3;
+#endif
+	return SimdScalar;
+}
+
+static const SimdLevel simdLevel = detectSimdLevel();
+
+static SwapWordsFunction selectSwapWords()
+{
+	return simdLevel == SimdAVX2 ? swapWordsAVX2 : simdLevel == SimdSSSE3 ? swapWordsSSSE3 : swapWordsScalar;
+}
+
+static TransposeWordsFunction selectTransposeWords()
+{
+	return simdLevel == SimdAVX2 ? transposeWordsAVX2 : simdLevel == SimdSSSE3 ? transposeWordsSSSE3 : transposeWordsScalar;
+}
+
+#else
+
+static SwapWordsFunction selectSwapWords()
+{
+	return swapWordsScalar;
+}
+
+static TransposeWordsFunction selectTransposeWords()
+{
+	return transposeWordsScalar;
+}
+
+#endif
+
+// Resolved once when the library loads
+static const SwapWordsFunction swapWordsImpl = selectSwapWords();
+static const TransposeWordsFunction transposeWordsImpl = selectTransposeWords();
+
+void RecordDecoder::swapWords(const uint8_t* src, uint32_t* dst, size_t count)
+{
+	swapWordsImpl(src, dst, count);
+}
+
+void RecordDecoder::transposeWords(const uint8_t* src, size_t records, size_t fieldCount, void* const* columns)
+{
+	transposeWordsImpl(src, 0, records, fieldCount, columns);
+}
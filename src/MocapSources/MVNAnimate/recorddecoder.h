@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#include "segmenttable.h"
+#include "streamer.h"
+
+/*! \class RecordColumns
+	\brief Structure-of-arrays storage for a packet of fixed-size segment records
+
+	Most pose and kinematics datagrams are an array of records made of a 4 byte segment ID followed
+	by FieldCount - 1 single precision floats. The decoded records are stored column-wise: the IDs
+	in segmentId and every float field in its own contiguous column, indexed by record number.
+	Fields are numbered in wire order, so field 0 is the segment ID and field 1 the first float.
+	The segments table maps every segment ID in the packet to its record number.
+*/
+template<size_t FieldCount, size_t Capacity>
+struct RecordColumns
+{
+	static constexpr size_t Fields = FieldCount;
+	static constexpr size_t RecordSize = FieldCount * sizeof(uint32_t);
+
+	// Segment IDs are a byte in practice, MVN sends at most 67 segments per avatar
+	static constexpr size_t MaxSegmentIds = 256;
+
+	alignas(32) int32_t segmentId[Capacity];
+	alignas(32) float values[FieldCount - 1][Capacity];
+	size_t count = 0;
+	SegmentTable<MaxSegmentIds> segments;
+
+	/*! The record number holding \a id, or -1 if the packet did not contain it */
+	inline int find(int32_t id) const { return segments.find(id); }
+
+	inline void clear()
+	{
+		count = 0;
+		segments.clear();
+	}
+
+	inline float* column(size_t field) { return values[field - 1]; }
+	inline const float* column(size_t field) const { return values[field - 1]; }
+};
+
+namespace RecordDecoder
+{
+	/*! Convert \a count big endian 32 bit words at \a src to host order at \a dst.
+		Uses AVX2 or SSSE3 shuffles when the CPU has them and a scalar loop otherwise.
+	*/
+	void swapWords(const uint8_t* src, uint32_t* dst, size_t count);
+
+	/*! Byte swap \a records big endian records of \a fieldCount 32 bit words at \a src and store
+		word f of record r at columns[f][r]. The AVX2 and SSSE3 kernels swap and transpose whole
+		blocks of records in registers, so every word is loaded and stored once.
+	*/
+	void transposeWords(const uint8_t* src, size_t records, size_t fieldCount, void* const* columns);
+
+	/*! Byte swap and de-interleave \a records wire records at \a src into \a out */
+	template<size_t FieldCount, size_t Capacity>
+	size_t decode(const uint8_t* src, size_t records, RecordColumns<FieldCount, Capacity>& out)
+	{
+		if (records > Capacity)
+			records = Capacity;
+
+		void* columns[FieldCount];
+		columns[0] = out.segmentId;
+		for (size_t f = 1; f < FieldCount; f++)
+			columns[f] = out.values[f - 1];
+		transposeWords(src, records, FieldCount, columns);
+
+		// the first record of a segment wins, as it did with a linear search
+		out.segments.clear();
+		for (size_t r = 0; r < records; r++)
+			if (!out.segments.contains(out.segmentId[r]))
+				out.segments.set(out.segmentId[r], r);
+
+		out.count = records;
+		return records;
+	}
+
+	/*! Call \a sink(segmentId, fields) for every record of the \a records wire records at \a src
+		whose segment ID is in \a wanted, in ascending segment ID order. \a fields points to the
+		FieldCount - 1 float fields of the record in host order, and is only valid during the call.
+		MVN sends segment ID n as record n - 1, so each wanted record is read straight from that
+		offset, and the IDs are only searched when a stream does not follow that order. The other
+		records are never touched. Returns the number of records passed to the sink.
+	*/
+	template<size_t FieldCount, size_t MaxSegmentIds, typename Sink>
+	size_t forEachRecord(const uint8_t* src, size_t records, const SegmentMask<MaxSegmentIds>& wanted, Sink&& sink)
+	{
+		const size_t RecordSize = FieldCount * sizeof(uint32_t);
+		uint32_t words[FieldCount];
+		float fields[FieldCount - 1];
+
+		size_t count = 0;
+		wanted.forEach([&](int32_t segmentId) {
+			size_t index = (size_t)segmentId - 1;
+			if (index >= records || WireOrder::load<int32_t>(src + index * RecordSize) != segmentId)
+			{
+				for (index = 0; index < records; index++)
+					if (WireOrder::load<int32_t>(src + index * RecordSize) == segmentId)
+						break;
+				if (index == records)
+					return;
+			}
+
+			swapWords(src + index * RecordSize, words, FieldCount);
+			memcpy(fields, words + 1, sizeof(fields));
+			sink(segmentId, (const float*)fields);
+			count++;
+		});
+		return count;
+	}
+
+	/*! Byte swap and de-interleave only the records whose segment ID is in \a wanted, see
+		forEachRecord. Decoded records are stored in ascending segment ID order.
+	*/
+	template<size_t FieldCount, size_t Capacity, size_t MaxSegmentIds>
+	size_t decode(const uint8_t* src, size_t records, const SegmentMask<MaxSegmentIds>& wanted, RecordColumns<FieldCount, Capacity>& out)
+	{
+		if (records > Capacity)
+			records = Capacity;
+
+		out.segments.clear();
+
+		size_t count = 0;
+		forEachRecord<FieldCount>(src, records, wanted, [&](int32_t segmentId, const float* fields) {
+			out.segmentId[count] = segmentId;
+			out.segments.set(segmentId, count);
+			for (size_t f = 1; f < FieldCount; f++)
+				out.values[f - 1][count] = fields[f - 1];
+			count++;
+		});
+
+		out.count = count;
+		return count;
+	}
+
+	/*! Decode the records selected by \a wanted, or every record when it is null */
+	template<size_t FieldCount, size_t Capacity, size_t MaxSegmentIds>
+	size_t decode(const uint8_t* src, size_t records, const SegmentMask<MaxSegmentIds>* wanted, RecordColumns<FieldCount, Capacity>& out)
+	{
+		return wanted ? decode(src, records, *wanted, out) : decode(src, records, out);
+	}
+}
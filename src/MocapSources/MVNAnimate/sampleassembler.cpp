@@ -0,0 +1,153 @@
+#include "sampleassembler.h"
+
+#include <cstring>
+
+SampleAssembler::SampleAssembler()
+	: m_slabs(MaxPendingSamples * MaxFragments * DatagramBatch::MaxDatagramSize)
+	, m_assembled(DatagramHeader::Size + MaxFragments * DatagramBatch::MaxDatagramSize)
+	, m_assembledSize(0)
+	, m_header()
+	, m_evicted(0)
+	, m_rejected(0)
+{
+	for (Slot& slot : m_slots)
+		slot.used = false;
+}
+
+bool SampleAssembler::add(const DatagramHeader& header, const uint8_t* data, size_t size)
+{
+	Clock::time_point now = Clock::now();
+	evictExpired(now);
+
+	size_t index = header.datagramCounter & 0x7F;
+	bool last = (header.datagramCounter & 0x80) != 0;
+	if (index >= MaxFragments || size < DatagramHeader::Size || size > DatagramBatch::MaxDatagramSize) {
+		m_rejected++;
+		return false;
+	}
+
+	Slot* slot = find(header);
+	if (slot == nullptr)
+		slot = claim(header, now);
+
+	if (slot->lastIndex >= 0 && (int)index > slot->lastIndex) {
+		m_rejected++;
+		return false;
+	}
+
+	size_t slotIndex = slot - m_slots;
+	memcpy(fragment(slotIndex, index), data, size);
+	slot->payloadSize[index] = size - DatagramHeader::Size;
+	slot->itemCount[index] = header.dataCount;
+	slot->received |= 1u << index;
+	if (index == 0)
+		slot->first = header;
+	if (last) {
+		slot->lastIndex = (int)index;
+
+		// Fragments that arrived earlier with an index past the last one can never be part of
+		// this sample, drop them so it completes as soon as the rest is in
+		uint32_t stray = slot->received & ~((2u << index) - 1);
+		for (; stray != 0; stray &= stray - 1)
+			m_rejected++;
+		slot->received &= (2u << index) - 1;
+	}
+
+	if (slot->lastIndex < 0 || slot->received != (2u << slot->lastIndex) - 1)
+		return false;
+
+	bool joined = join(*slot);
+	slot->used = false;
+	return joined;
+}
+
+SampleAssembler::Slot* SampleAssembler::find(const DatagramHeader& header)
+{
+	for (Slot& slot : m_slots)
+	{
+		if (slot.used && slot.sampleCounter == header.sampleCounter
+			&& slot.avatarId == header.avatarId && slot.protocol == header.protocol)
+			return &slot;
+	}
+	return nullptr;
+}
+
+/*! Take a free slot for a new sample, reusing the oldest partial sample if none is free */
+SampleAssembler::Slot* SampleAssembler::claim(const DatagramHeader& header, Clock::time_point now)
+{
+	Slot* chosen = nullptr;
+	for (Slot& slot : m_slots)
+	{
+		if (!slot.used) {
+			chosen = &slot;
+			break;
+		}
+		if (chosen == nullptr || slot.started < chosen->started)
+			chosen = &slot;
+	}
+
+	if (chosen->used)
+		m_evicted++;
+
+	chosen->used = true;
+	chosen->avatarId = header.avatarId;
+	chosen->protocol = header.protocol;
+	chosen->sampleCounter = header.sampleCounter;
+	chosen->received = 0;
+	chosen->lastIndex = -1;
+	chosen->started = now;
+	return chosen;
+}
+
+void SampleAssembler::evictExpired(Clock::time_point now)
+{
+	for (Slot& slot : m_slots)
+	{
+		if (slot.used && now - slot.started > Deadline) {
+			slot.used = false;
+			m_evicted++;
+		}
+	}
+}
+
+/*! Concatenate the payloads of a finished sample behind the header of its first fragment */
+bool SampleAssembler::join(Slot& slot)
+{
+	size_t slotIndex = &slot - m_slots;
+	size_t items = 0;
+	size_t payload = 0;
+	for (int i = 0; i <= slot.lastIndex; i++)
+	{
+		items += slot.itemCount[i];
+		payload += slot.payloadSize[i];
+	}
+
+	// The joined header has to describe the sample in the same one byte item count
+	if (items > 0xFF || payload > 0xFFFF) {
+		m_rejected++;
+		return false;
+	}
+
+	uint8_t* out = m_assembled.data();
+	memcpy(out, fragment(slotIndex, 0), DatagramHeader::Size);
+	size_t offset = DatagramHeader::Size;
+	for (int i = 0; i <= slot.lastIndex; i++)
+	{
+		memcpy(out + offset, fragment(slotIndex, i) + DatagramHeader::Size, slot.payloadSize[i]);
+		offset += slot.payloadSize[i];
+	}
+
+	m_header = slot.first;
+	m_header.datagramCounter = 0x80;
+	m_header.dataCount = (uint8_t)items;
+	m_header.dataSize = (uint16_t)payload;
+
+	// Keep the raw header in step, so the joined packet also parses on its own
+	out[10] = m_header.datagramCounter;
+	out[11] = m_header.dataCount;
+	out[22] = (uint8_t)(m_header.dataSize >> 8);
+	out[23] = (uint8_t)(m_header.dataSize & 0xFF);
+
+	m_assembledSize = offset;
+	return true;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include <vector>
+
+#include "datagram.h"
+#include "datagrambatch.h"
+
+/*! \class SampleAssembler
+	\brief Joins a sample that MVN split over several datagrams back into one packet
+
+	Fragments of one sample share avatar ID, protocol and sample counter, and carry their index in
+	the low 7 bits of the datagram counter. The last fragment has the 0x80 bit set. Fragments may
+	arrive in any order. Once every index up to the last one is present, the payloads are joined
+	behind a single header whose item count and data size cover the whole sample. Fragments with an
+	index past the last one are dropped and counted as rejected.
+
+	All slab memory is allocated up front, so collecting fragments never touches the heap.
+	Partial samples that are not finished within the deadline are dropped, as is the oldest
+	partial sample when every slot is taken.
+*/
+class SampleAssembler
+{
+public:
+	static constexpr size_t MaxPendingSamples = 8;
+	static constexpr size_t MaxFragments = 16;
+
+	// Partial samples older than this are evicted, a few frames at 240 Hz
+	static constexpr std::chrono::milliseconds Deadline{ 50 };
+
+	SampleAssembler();
+
+	SampleAssembler(SampleAssembler const&) = delete;
+	SampleAssembler& operator=(SampleAssembler const&) = delete;
+
+	/*! Store one fragment. Returns true when it completed its sample, which is then available
+		from header(), data() and size() until the next call.
+	*/
+	bool add(const DatagramHeader& header, const uint8_t* data, size_t size);
+
+	inline const DatagramHeader& header() const { return m_header; }
+	inline const uint8_t* data() const { return m_assembled.data(); }
+	inline size_t size() const { return m_assembledSize; }
+
+	inline uint64_t evictedCount() const { return m_evicted; }
+	inline uint64_t rejectedCount() const { return m_rejected; }
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Slot
+	{
+		bool used;
+		uint8_t avatarId;
+		uint8_t protocol;
+		int32_t sampleCounter;
+		uint32_t received;			// bit per fragment index
+		int lastIndex;				// -1 until the fragment with the 0x80 bit arrives
+		Clock::time_point started;
+		DatagramHeader first;		// header of fragment 0, the template for the joined header
+		size_t payloadSize[MaxFragments];
+		uint8_t itemCount[MaxFragments];
+	};
+
+	Slot* find(const DatagramHeader& header);
+	Slot* claim(const DatagramHeader& header, Clock::time_point now);
+	void evictExpired(Clock::time_point now);
+	bool join(Slot& slot);
+
+	inline uint8_t* fragment(size_t slot, size_t index)
+	{
+		return m_slabs.data() + (slot * MaxFragments + index) * DatagramBatch::MaxDatagramSize;
+	}
+
+	Slot m_slots[MaxPendingSamples];
+	std::vector<uint8_t> m_slabs;
+	std::vector<uint8_t> m_assembled;
+	size_t m_assembledSize;
+	DatagramHeader m_header;
+
+	uint64_t m_evicted;
+	uint64_t m_rejected;
+};
@@ -66,6 +66,11 @@ ScaleDatagram::~ScaleDatagram()
 void ScaleDatagram::deserializeData(Streamer &inputStreamer)
 {
 	Streamer* streamer = &inputStreamer;
+
+	// Pooled instances are reused, drop the previous packet without releasing capacity
+	m_tPose.clear();
+	m_pointDefinitions.clear();
+
 	// The first packet contains the null pose definition.
 
 	// 4 bytes: the number of segments as an unsigned integer
@@ -85,8 +90,10 @@ void ScaleDatagram::deserializeData(Streamer &inputStreamer)
 		nullPosDef.segmentName = str;
 
 		// 3-component vector: the position of the origin of the segment in the null pose
-		for (int k = 0; k < 3; k++)
-			streamer->read(nullPosDef.pos[k]);
+		streamer->read(nullPosDef.pos, 3);
+
+		if (!streamer->ok())
+			break;
 
 		m_tPose.push_back(nullPosDef);
 	}
@@ -124,8 +131,10 @@ void ScaleDatagram::deserializeData(Streamer &inputStreamer)
 			streamer->read(pointDef.characteristicOfPoint);
 
 			// 3-component vector: the position of the point relative to the segment origin in the null pose
-			for (int k = 0; k < 3; k++)
-				streamer->read(pointDef.pos[k]);
+			streamer->read(pointDef.pos, 3);
+
+			if (!streamer->ok())
+				break;
 
 			m_pointDefinitions.push_back(pointDef);
 		}
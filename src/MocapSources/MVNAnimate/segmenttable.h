@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/*! \class SegmentMask
+	\brief A set of segment IDs, one bit each
+
+	Iterating walks only the set bits, lowest ID first, so a sparse set of a few tracked segments
+	costs a few instructions per member rather than one per possible ID.
+*/
+template<size_t MaxSegmentIds>
+class SegmentMask
+{
+public:
+	static constexpr size_t Capacity = MaxSegmentIds;
+	static constexpr size_t Words = (MaxSegmentIds + 63) / 64;
+
+	inline void clear()
+	{
+		for (size_t w = 0; w < Words; w++)
+			m_bits[w] = 0;
+	}
+
+	/*! Add \a segmentId to the set. IDs outside the mask are ignored. */
+	inline bool set(int32_t segmentId)
+	{
+		if (segmentId < 0 || (size_t)segmentId >= MaxSegmentIds)
+			return false;
+		m_bits[segmentId >> 6] |= uint64_t(1) << (segmentId & 63);
+		return true;
+	}
+
+	inline bool contains(int32_t segmentId) const
+	{
+		return segmentId >= 0 && (size_t)segmentId < MaxSegmentIds
+			&& (m_bits[segmentId >> 6] >> (segmentId & 63)) & 1;
+	}
+
+	inline bool empty() const
+	{
+		for (size_t w = 0; w < Words; w++)
+			if (m_bits[w])
+				return false;
+		return true;
+	}
+
+	/*! Call \a visit(segmentId) for every ID in the set, in ascending order */
+	template<typename Visitor>
+	void forEach(Visitor visit) const
+	{
+		for (size_t w = 0; w < Words; w++)
+		{
+			uint64_t bits = m_bits[w];
+			while (bits)
+			{
+				visit((int32_t)(w * 64 + lowestBit(bits)));
+				bits &= bits - 1;
+			}
+		}
+	}
+
+private:
+	static inline unsigned lowestBit(uint64_t bits)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward64(&index, bits);
+		return (unsigned)index;
+#else
+		return (unsigned)__builtin_ctzll(bits);
+#endif
+	}
+
+	uint64_t m_bits[Words] = {};
+};
+
+/*! \class SegmentTable
+	\brief Maps the segment IDs of one datagram to the index of their record
+
+	Records arrive in whatever order MVN sends them, so this table is filled while decoding.
+	Each ID has a slot in a dense array and a bit in a SegmentMask that says whether the slot is
+	valid. A lookup is a bounds check plus an index. Iterating walks only the set bits. Clearing
+	only resets the mask, and stale slots are never read because their bit is off.
+*/
+template<size_t MaxSegmentIds>
+class SegmentTable
+{
+public:
+	static constexpr size_t Capacity = MaxSegmentIds;
+
+	inline void clear()
+	{
+		m_present.clear();
+	}
+
+	/*! Record that \a segmentId is stored at \a index. IDs outside the table are ignored. */
+	inline bool set(int32_t segmentId, size_t index)
+	{
+		if (!m_present.set(segmentId))
+			return false;
+		m_index[segmentId] = (uint8_t)index;
+		return true;
+	}
+
+	inline bool contains(int32_t segmentId) const
+	{
+		return m_present.contains(segmentId);
+	}
+
+	/*! The record index of \a segmentId, or -1 if the datagram did not contain it */
+	inline int find(int32_t segmentId) const
+	{
+		return contains(segmentId) ? m_index[segmentId] : -1;
+	}
+
+	/*! Call \a visit(segmentId, index) for every present segment, in ascending ID order */
+	template<typename Visitor>
+	void forEach(Visitor visit) const
+	{
+		m_present.forEach([&](int32_t segmentId) {
+			visit(segmentId, (size_t)m_index[segmentId]);
+		});
+	}
+
+private:
+	// Record indices fit a byte since a datagram holds at most 255 items
+	uint8_t m_index[MaxSegmentIds];
+	SegmentMask<MaxSegmentIds> m_present;
+};
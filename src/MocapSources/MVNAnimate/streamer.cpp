@@ -41,147 +41,63 @@
 	Base_Address+1 Byte2
 	Base_Address+2 Byte1
 	Base_Address+3 Byte0
-*/
-
-Streamer::Streamer(const XsByteArray& arr)
-	: m_offset(0)
-{
-	// reference to the real data
-	m_array = &arr;
-
-	// check Endianess
-	int num = 1;
-	if(*(char *)&num == 1)
-	{
-		m_endianess = Little_Endian;
-	}
-	else
-	{
-		m_endianess = Big_Endian;
-	}
-}
-
-/*! Destructor */
-Streamer::~Streamer()
-{
-}
 
-/*! Extract 4 byte from the ByteArray and Store the value into a int32_t (4 byte) variable */
-void Streamer::read(int32_t &destination)
-{
-	char byte_array[4];
-
-	// copy part of the original byte array into a temp array
-	memcpy(byte_array, m_array->data()+m_offset, sizeof(destination));
-
-	if (m_endianess == Little_Endian)
-		destination = (byte_array[0] << 24) | ((byte_array[1] & 0xff) << 16) | ((byte_array[2] & 0xff) << 8) | (byte_array[3] & 0xff);
-	else
-		destination = (byte_array[3] << 24) | ((byte_array[2] & 0xff) << 16) | ((byte_array[1] & 0xff) << 8) | (byte_array[0] & 0xff);
-
-	// increase the index
-	m_offset += 4;
-}
+	The network stream is big endian, see WireOrder for the conversion.
+*/
 
-/*! Extract 1 byte from the ByteArray and Store the value into a int8_t (1 byte) variable */
-void Streamer::read(int8_t &destination)
+Streamer::Streamer(const uint8_t* data, size_t size)
+	: m_data(data)
+	, m_size(size)
+	, m_offset(0)
+	, m_ok(data != nullptr || size == 0)
 {
-	int8_t res;
-
-	memcpy(&res, m_array->data()+m_offset, 1);
-	destination = (int)res & 0xFF;
-
-	// increase the index
-	m_offset++;
 }
 
-/*! Extract 2 byte from the ByteArray and Store the value into a int16_t (2 byte) variable */
-void Streamer::read(int16_t &destination)
+Streamer::Streamer(const ByteArray& arr)
+	: Streamer(arr.data(), arr.size())
 {
-	char byte_array[2];
-
-	// copy part of the original byte array into a temp array
-	memcpy(byte_array, m_array->data()+m_offset, 2);
-
-	if (m_endianess == Little_Endian)
-		destination = ((byte_array[0] & 0xff) << 8) | (byte_array[1] & 0xff);
-	else
-		destination = ((byte_array[1] & 0xff) << 8) | (byte_array[0] & 0xff);
-
-	// increase the index
-	m_offset += 2;
 }
 
-/*! Extract 2 byte from the ByteArray and Store the value into a uint16_t (2 byte) variable */
-void Streamer::read(uint16_t &destination)
+/*! Destructor */
+Streamer::~Streamer()
 {
-	uint8_t byte_array[2];
-
-	// copy part of the original byte array into a temp array
-	memcpy(byte_array, m_array->data()+m_offset, 2);
-
-	if (m_endianess == Little_Endian)
-		destination = ((byte_array[0] & 0xff) << 8) | (byte_array[1] & 0xff);
-	else
-		destination = ((byte_array[1] & 0xff) << 8) | (byte_array[0] & 0xff);
-
-	// increase the index
-	m_offset += 2;
 }
 
-/*! Extract 1 byte from the ByteArray and Store the value into a uint8_t (1 byte) variable */
-void Streamer::read(uint8_t &destination)
+/*! Extract "numChars" bytes from the packet and store them into a string variable */
+bool Streamer::read(std::string& str, int numChars)
 {
-	uint8_t res;
+	if (numChars < 0 || !fits((size_t)numChars)) {
+		str.clear();
+		return false;
+	}
 
-	memcpy(&res, m_array->data()+m_offset, 1);
-	destination = (int)res & 0xFF;
+	// stop at an embedded terminator, like the null terminated copy this replaces
+	const char* chars = reinterpret_cast<const char*>(m_data + m_offset);
+	const void* terminator = memchr(chars, '\0', numChars);
+	str.assign(chars, terminator ? (const char*)terminator - chars : numChars);
 
 	// increase the index
-	m_offset++;
+	m_offset += numChars;
+	return true;
 }
 
-/*! Extract 4 byte from the ByteArray and Store the value into a float (4 byte) variable */
-void Streamer::read(float &destination)
+/*! Reference the next \a numBytes of the packet in \a block, without copying them */
+bool Streamer::readBlock(const uint8_t*& block, size_t numBytes)
 {
-	float output = 0.0;
-
-	unsigned char byte_array[4];
-	// copy part of the original byte array into a temp array
-	memcpy(&byte_array, m_array->data()+m_offset, sizeof(destination));
-
-	if (m_endianess == Little_Endian)
-	{
-		*((unsigned char*)(&output) + 3) = byte_array[0];
-		*((unsigned char*)(&output) + 2) = byte_array[1];
-		*((unsigned char*)(&output) + 1) = byte_array[2];
-		*((unsigned char*)(&output) + 0) = byte_array[3];
-	}
-	else
-	{
-		*((unsigned char*)(&output) + 3) = byte_array[3];
-		*((unsigned char*)(&output) + 2) = byte_array[2];
-		*((unsigned char*)(&output) + 1) = byte_array[1];
-		*((unsigned char*)(&output) + 0) = byte_array[0];
+	if (!fits(numBytes)) {
+		block = nullptr;
+		return false;
 	}
-
-	destination = output;
-
-	// increase the index
-	m_offset += 4;
+	block = m_data + m_offset;
+	m_offset += numBytes;
+	return true;
 }
 
-/*! Extract "size" byte from the ByteArray and Store the value into a string variable */
-void Streamer::read(std::string& str, int numChars)
+/*! Skip over \a numBytes of the packet */
+bool Streamer::skip(size_t numBytes)
 {
-	char * buffer = new char[numChars + 1];
-
-	memcpy(buffer, m_array->data()+m_offset, numChars);
-	buffer[numChars] = '\0';
-
-	str = buffer;
-	delete[] buffer;
-
-	// increase the index
-	m_offset += numChars;
+	if (!fits(numBytes))
+		return false;
+	m_offset += numBytes;
+	return true;
 }
@@ -30,33 +30,155 @@
 #include <memory>
 #include <iostream>
 #include <sstream>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
 
-#include <xstypes/xsbytearray.h>
+#if defined(_MSC_VER)
+#include <stdlib.h>
+#endif
+
+#include "bytearray.h"
+
+/*! MVN sends every multi-byte field in network (big endian) order. The host order is known at
+	compile time, so swapping is a single bswap instruction on little endian hosts and nothing at
+	all on big endian ones.
+*/
+namespace WireOrder
+{
+#if defined(_MSC_VER) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+	constexpr bool HostIsLittleEndian = true;
+#else
+	constexpr bool HostIsLittleEndian = false;
+#endif
+
+	inline uint16_t byteSwap(uint16_t value)
+	{
+#if defined(_MSC_VER)
+		return _byteswap_ushort(value);
+#else
+		return __builtin_bswap16(value);
+#endif
+	}
+
+	inline uint32_t byteSwap(uint32_t value)
+	{
+#if defined(_MSC_VER)
+		return _byteswap_ulong(value);
+#else
+		return __builtin_bswap32(value);
+#endif
+	}
+
+	/*! Load a big endian value of type \a T from an unaligned wire position */
+	template<typename T>
+	inline T load(const uint8_t* src)
+	{
+		static_assert(std::is_arithmetic<T>::value && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4),
+			"MVN wire fields are 1, 2 or 4 byte integers or single precision floats");
 
+		T value;
+		if constexpr (sizeof(T) == 1 || !HostIsLittleEndian)
+		{
+			memcpy(&value, src, sizeof(T));
+		}
+		else
+		{
+			typedef typename std::conditional<sizeof(T) == 2, uint16_t, uint32_t>::type Raw;
+			Raw raw;
+			memcpy(&raw, src, sizeof(Raw));
+			raw = byteSwap(raw);
+			memcpy(&value, &raw, sizeof(T));
+		}
+		return value;
+	}
+
+	/*! Store \a value of type \a T in big endian order at an unaligned wire position */
+	template<typename T>
+	inline void store(uint8_t* dst, T value)
+	{
+		static_assert(std::is_arithmetic<T>::value && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4),
+			"MVN wire fields are 1, 2 or 4 byte integers or single precision floats");
+
+		if constexpr (sizeof(T) == 1 || !HostIsLittleEndian)
+		{
+			memcpy(dst, &value, sizeof(T));
+		}
+		else
+		{
+			typedef typename std::conditional<sizeof(T) == 2, uint16_t, uint32_t>::type Raw;
+			Raw raw;
+			memcpy(&raw, &value, sizeof(Raw));
+			raw = byteSwap(raw);
+			memcpy(dst, &raw, sizeof(Raw));
+		}
+	}
+}
+
+/*! \class Streamer
+	\brief A read cursor over a received packet
+
+	The streamer only references the packet, nothing is copied. Every read is bounds checked: a
+	read past the end leaves the destination zeroed, returns false and latches ok() to false.
+*/
 class Streamer
 {
 public:
-	Streamer(const XsByteArray& arr);
+	Streamer(const uint8_t* data, size_t size);
+	Streamer(const ByteArray& arr);
 	~Streamer();
 
-	void read(int32_t &destination);
-	void read(int8_t &destination);
-	void read(int16_t &destination);
-	void read(uint16_t &destination);
-	void read(uint8_t &destination);
-	void read(float &destination);
-	void read(std::string& str, int numChars);
+	template<typename T>
+	inline bool read(T &destination)
+	{
+		if (!fits(sizeof(T))) {
+			destination = T();
+			return false;
+		}
+		destination = WireOrder::load<T>(m_data + m_offset);
+		m_offset += sizeof(T);
+		return true;
+	}
 
-private:
+	/*! Read \a count consecutive values of type \a T */
+	template<typename T>
+	inline bool read(T* destination, size_t count)
+	{
+		if (!fits(sizeof(T) * count)) {
+			for (size_t i = 0; i < count; i++)
+				destination[i] = T();
+			return false;
+		}
+		for (size_t i = 0; i < count; i++)
+			destination[i] = WireOrder::load<T>(m_data + m_offset + i * sizeof(T));
+		m_offset += sizeof(T) * count;
+		return true;
+	}
+
+	bool read(std::string& str, int numChars);
+	bool readBlock(const uint8_t*& block, size_t numBytes);
+	bool skip(size_t numBytes);
+
+	/*! Mark the packet as malformed, for checks the reads themselves cannot make */
+	inline void fail() { m_ok = false; }
 
-	enum Endianess  {
-		Little_Endian,
-		Big_Endian
-	};
+	inline bool ok() const { return m_ok; }
+	inline size_t offset() const { return m_offset; }
+	inline size_t remaining() const { return m_size - m_offset; }
+	inline const uint8_t* current() const { return m_data + m_offset; }
+
+private:
+	inline bool fits(size_t numBytes)
+	{
+		if (numBytes > m_size - m_offset)
+			m_ok = false;
+		return m_ok;
+	}
 
-	const XsByteArray* m_array;
-	int m_offset;
-	Endianess m_endianess;
+	const uint8_t* m_data;
+	size_t m_size;
+	size_t m_offset;
+	bool m_ok;
 };
 
 #endif
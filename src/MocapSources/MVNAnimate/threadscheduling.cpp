@@ -0,0 +1,80 @@
+#include "threadscheduling.h"
+
+#include <cstring>
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux) || defined(__linux__) || defined(linux)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+
+std::string ThreadScheduling::apply(std::thread& thread) const
+{
+	std::string report;
+	HANDLE handle = (HANDLE)thread.native_handle();
+
+	if (cpu >= 0) {
+		if (cpu < 64 && SetThreadAffinityMask(handle, DWORD_PTR(1) << cpu) != 0)
+			report += "pinned to CPU " + std::to_string(cpu);
+		else
+			report += "pinning to CPU " + std::to_string(cpu) + " failed (error " + std::to_string(GetLastError()) + ")";
+	}
+
+	if (realtime) {
+		if (!report.empty())
+			report += ", ";
+		if (SetThreadPriority(handle, THREAD_PRIORITY_TIME_CRITICAL))
+			report += "time critical priority";
+		else
+			report += "time critical priority denied (error " + std::to_string(GetLastError()) + ")";
+	}
+	return report.empty() ? "default scheduling" : report;
+}
+
+#elif defined(__linux) || defined(__linux__) || defined(linux)
+
+std::string ThreadScheduling::apply(std::thread& thread) const
+{
+	std::string report;
+	pthread_t handle = thread.native_handle();
+
+	if (cpu >= 0) {
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		int error = cpu < CPU_SETSIZE ? 0 : EINVAL;
+		if (!error) {
+			CPU_SET(cpu, &set);
+			error = pthread_setaffinity_np(handle, sizeof(set), &set);
+		}
+		if (!error)
+			report += "pinned to CPU " + std::to_string(cpu);
+		else
+			report += "pinning to CPU " + std::to_string(cpu) + " failed (" + strerror(error) + ")";
+	}
+
+	if (realtime) {
+		if (!report.empty())
+			report += ", ";
+		sched_param param = {};
+		param.sched_priority = RealtimePriority;
+		int error = pthread_setschedparam(handle, SCHED_FIFO, &param);
+		if (!error)
+			report += "SCHED_FIFO priority " + std::to_string(RealtimePriority);
+		else
+			report += std::string("SCHED_FIFO denied (") + strerror(error) + ")";
+	}
+	return report.empty() ? "default scheduling" : report;
+}
+
+#else
+
+std::string ThreadScheduling::apply(std::thread&) const
+{
+	return isDefault() ? "default scheduling" : "thread scheduling is not supported on this platform";
+}
+
+#endif
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <thread>
+
+/*! \struct ThreadScheduling
+	\brief Core placement and priority for a latency critical thread
+
+	Both are requests: pinning fails on a core that does not exist, and real-time priority needs
+	CAP_SYS_NICE or an RLIMIT_RTPRIO allowance on Linux. apply() reports what was granted, so a
+	denied request shows up in the log instead of silently running with default scheduling.
+*/
+struct ThreadScheduling
+{
+	// Core to pin the thread to, -1 leaves placement to the OS
+	int cpu = -1;
+
+	// SCHED_FIFO on Linux, time critical priority on Windows
+	bool realtime = false;
+
+	// SCHED_FIFO priority, low enough that kernel interrupt threads (50) still preempt it
+	static const int RealtimePriority = 10;
+
+	inline bool isDefault() const { return cpu < 0 && !realtime; }
+
+	// Apply to a running thread, returns a description of the outcome for the log
+	std::string apply(std::thread& thread) const;
+};
@@ -0,0 +1,223 @@
+#include "udpreceiver.h"
+#include "threadscheduling.h"
+#include "LatencyHistogram.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET SocketHandle;
+#elif defined(__linux) || defined(__linux__) || defined(linux)
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+typedef int SocketHandle;
+#endif
+
+/*! Receive wake-up jitter for each receive thread scheduling mode
+
+	A sender thread stamps small datagrams with the time they leave and sends them over loopback at
+	a steady rate. For every mode the receive thread is set up as the driver would be, and the time
+	from send to receive() returning is collected. The spread of that number is what pose timing
+	sees from the receive side. Run it with the load of a real session, e.g. next to vrserver.
+*/
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	struct Mode
+	{
+		const char* name;
+		bool pin;
+		bool realtime;
+		bool spin;
+		bool busyPoll;
+	};
+
+	struct Options
+	{
+		uint16_t port = 9764;
+		int count = 2000;
+		int rate = 240;
+		int cpu = 0;
+		uint32_t spinUs = 200;
+		uint32_t busyPollUs = 50;
+	};
+
+	uint64_t nowNs()
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+	}
+
+	void send(const Options& options, std::atomic_bool& stop)
+	{
+		SocketHandle sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		sockaddr_in destination = {};
+		destination.sin_family = AF_INET;
+		destination.sin_port = htons(options.port);
+		inet_pton(AF_INET, "127.0.0.1", &destination.sin_addr);
+
+		const std::chrono::nanoseconds period(1000000000LL / options.rate);
+		Clock::time_point next = Clock::now();
+		while (!stop)
+		{
+			std::this_thread::sleep_until(next);
+			next += period;
+
+			uint64_t sent = nowNs();
+			sendto(sock, (const char*)&sent, sizeof(sent), 0, (const sockaddr*)&destination, sizeof(destination));
+		}
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+		closesocket(sock);
+#else
+		close(sock);
+#endif
+	}
+
+	void run(const Mode& mode, const Options& options)
+	{
+		UdpReceiver receiver;
+		if (!receiver.bind("127.0.0.1", options.port)) {
+			std::cout << "Failed to bind port " << options.port << std::endl;
+			return;
+		}
+
+		std::string setup;
+		receiver.setSpin(mode.spin ? options.spinUs : 0);
+		if (mode.busyPoll && !receiver.setBusyPoll(options.busyPollUs))
+			setup = "busy poll not permitted";
+
+		LatencyHistogram histogram;
+		std::vector<double> samples;
+		samples.reserve(options.count);
+
+		std::thread receiveThread([&]() {
+			DatagramBatch batch;
+			while ((int)samples.size() < options.count)
+			{
+				if (receiver.receive(batch, 1000) == 0)
+					continue;
+				uint64_t received = nowNs();
+				for (size_t i = 0; i < batch.count() && (int)samples.size() < options.count; i++)
+				{
+					uint64_t sent;
+					memcpy(&sent, batch.data(i), sizeof(sent));
+					histogram.Record(std::chrono::nanoseconds(received - sent));
+					samples.push_back((received - sent) / 1000.0);
+				}
+			}
+		});
+
+		ThreadScheduling scheduling;
+		scheduling.cpu = mode.pin ? options.cpu : -1;
+		scheduling.realtime = mode.realtime;
+		if (!scheduling.isDefault())
+			setup += (setup.empty() ? "" : ", ") + scheduling.apply(receiveThread);
+
+		std::atomic_bool stop(false);
+		std::thread sendThread(send, std::cref(options), std::ref(stop));
+		receiveThread.join();
+		stop = true;
+		sendThread.join();
+
+		double mean = 0.0;
+		for (double sample : samples)
+			mean += sample;
+		mean /= samples.size();
+		double variance = 0.0;
+		for (double sample : samples)
+			variance += (sample - mean) * (sample - mean);
+		double stddev = std::sqrt(variance / samples.size());
+
+		std::printf("%-18s %8.1f %8.1f %8llu %8llu %8llu %8.1f  %s\n", mode.name, mean, stddev,
+			(unsigned long long)histogram.Percentile(0.5), (unsigned long long)histogram.Percentile(0.99),
+			(unsigned long long)histogram.Percentile(0.999), samples.empty() ? 0.0 : *std::max_element(samples.begin(), samples.end()),
+			setup.c_str());
+	}
+
+	void usage()
+	{
+		std::cout
+			<< "Usage: MVNJitterBench [options]\n"
+			<< "  --port <port>          loopback port to use (9764)\n"
+			<< "  --count <n>            datagrams per mode (2000)\n"
+			<< "  --rate <hz>            send rate (240)\n"
+			<< "  --cpu <n>              core for the pinned modes (the last one)\n"
+			<< "  --spin <us>            spin time of the spin mode (200)\n"
+			<< "  --busy-poll <us>       SO_BUSY_POLL time of the busy poll mode (50)\n"
+			<< "  --mode <name>          run only this mode\n";
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	Options options;
+	std::string only;
+
+	// The last core is the one least likely to take the NIC interrupts and other pinned work
+	options.cpu = std::max(0, (int)std::thread::hardware_concurrency() - 1);
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		std::string value = i + 1 < argc ? argv[++i] : "";
+
+		if (arg == "--port") options.port = (uint16_t)std::stoi(value);
+		else if (arg == "--count") options.count = std::stoi(value);
+		else if (arg == "--rate") options.rate = std::stoi(value);
+		else if (arg == "--cpu") options.cpu = std::stoi(value);
+		else if (arg == "--spin") options.spinUs = (uint32_t)std::stoul(value);
+		else if (arg == "--busy-poll") options.busyPollUs = (uint32_t)std::stoul(value);
+		else if (arg == "--mode") only = value;
+		else {
+			usage();
+			return arg == "--help" ? 0 : 1;
+		}
+	}
+
+	if (options.count < 1 || options.rate < 1) {
+		usage();
+		return 1;
+	}
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+	WSADATA wsaData;
+	WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+
+	const Mode modes[] = {
+		{ "block", false, false, false, false },
+		{ "pinned", true, false, false, false },
+		{ "realtime", false, true, false, false },
+		{ "pinned+realtime", true, true, false, false },
+		{ "spin", false, false, true, false },
+		{ "busy-poll", false, false, false, true },
+		{ "all", true, true, true, true },
+	};
+
+	std::printf("Send to receive() return in us, %d datagrams at %d Hz per mode\n", options.count, options.rate);
+	std::printf("%-18s %8s %8s %8s %8s %8s %8s\n", "mode", "mean", "stddev", "p50", "p99", "p99.9", "max");
+	for (const Mode& mode : modes)
+	{
+		if (only.empty() || only == mode.name)
+			run(mode, options);
+	}
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+	WSACleanup();
+#endif
+	return 0;
+}
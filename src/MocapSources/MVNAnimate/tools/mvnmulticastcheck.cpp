@@ -0,0 +1,185 @@
+#include "mvnsynthesizer.h"
+#include "udpreceiver.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET SocketHandle;
+#elif defined(__linux) || defined(__linux__) || defined(linux)
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+typedef int SocketHandle;
+#endif
+
+/*! Multicast subscription over loopback
+
+	Several UdpReceivers join a multicast group on the loopback interface, sharing the port as the
+	driver and a recorder would, and a sender streams synthesized MXTP datagrams to the group.
+	Every receiver has to get every datagram byte for byte and in order. Exits non-zero otherwise,
+	so it can be run after touching the receive path or on a machine where multicast is in doubt.
+*/
+
+namespace
+{
+	typedef std::vector<uint8_t> Payload;
+
+	struct Options
+	{
+		std::string group = "239.255.76.63";
+		int port = 9771;
+		std::string interfaceAddress = "127.0.0.1";
+		int receivers = 2;
+		int samples = 240;
+		int rate = 240;
+	};
+
+	struct Subscriber
+	{
+		UdpReceiver receiver;
+		std::vector<Payload> received;
+		std::thread thread;
+	};
+
+	void usage()
+	{
+		std::cout
+			<< "Usage: MVNMulticastCheck [options]\n"
+			<< "  --group <ip>           multicast group (239.255.76.63)\n"
+			<< "  --port <port>          port (9771)\n"
+			<< "  --interface <ip>       interface to join and send on (127.0.0.1)\n"
+			<< "  --receivers <n>        receivers sharing the port (2)\n"
+			<< "  --samples <n>          quaternion samples to send (240)\n"
+			<< "  --rate <hz>            send rate (240)\n";
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	Options options;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		std::string value = i + 1 < argc ? argv[++i] : "";
+
+		if (arg == "--group") options.group = value;
+		else if (arg == "--port") options.port = std::stoi(value);
+		else if (arg == "--interface") options.interfaceAddress = value;
+		else if (arg == "--receivers") options.receivers = std::stoi(value);
+		else if (arg == "--samples") options.samples = std::stoi(value);
+		else if (arg == "--rate") options.rate = std::stoi(value);
+		else {
+			usage();
+			return arg == "--help" ? 0 : 1;
+		}
+	}
+
+	if (!UdpReceiver::isMulticast(options.group) || options.receivers < 1 || options.samples < 1 || options.rate < 1) {
+		usage();
+		return 1;
+	}
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+	WSADATA wsaData;
+	WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+
+	// Everything is sent up front into a list, so what arrives can be compared byte for byte
+	std::vector<Payload> sent;
+	MvnSynthesizer synthesizer(MvnSynthesizer::Config{});
+	for (int32_t sample = 0; sample < options.samples; sample++)
+		synthesizer.sample(SPPoseQuaternion, 0, sample, sample / (double)options.rate, [&sent](const uint8_t* data, size_t size) {
+			sent.emplace_back(data, data + size);
+		});
+
+	// Every receiver has joined before the first datagram goes out
+	std::vector<std::unique_ptr<Subscriber>> subscribers;
+	for (int i = 0; i < options.receivers; i++)
+	{
+		subscribers.emplace_back(new Subscriber);
+		if (!subscribers.back()->receiver.bindMulticast(options.group, (uint16_t)options.port, options.interfaceAddress)) {
+			std::cout << "Receiver " << i << " failed to join " << options.group << ":" << options.port
+				<< " on " << options.interfaceAddress << std::endl;
+			return 1;
+		}
+	}
+
+	std::atomic_bool sending(true);
+	for (std::unique_ptr<Subscriber>& subscriber : subscribers)
+	{
+		Subscriber* s = subscriber.get();
+		s->thread = std::thread([s, &sent, &sending]() {
+			DatagramBatch batch;
+			// Keeps going a second past the last send, so late datagrams are still counted
+			std::chrono::steady_clock::time_point quietUntil = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+			while (s->received.size() < sent.size() && (sending || std::chrono::steady_clock::now() < quietUntil))
+			{
+				if (sending)
+					quietUntil = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+				s->receiver.receive(batch, 100);
+				for (size_t i = 0; i < batch.count(); i++)
+					s->received.emplace_back(batch.data(i), batch.data(i) + batch.size(i));
+			}
+		});
+	}
+
+	SocketHandle sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	sockaddr_in destination = {};
+	destination.sin_family = AF_INET;
+	destination.sin_port = htons((uint16_t)options.port);
+	inet_pton(AF_INET, options.group.c_str(), &destination.sin_addr);
+
+	in_addr outgoing = {};
+	inet_pton(AF_INET, options.interfaceAddress.c_str(), &outgoing);
+	setsockopt(sock, IPPROTO_IP, IP_MULTICAST_IF, (const char*)&outgoing, sizeof(outgoing));
+
+	// The receivers are on this machine, which needs the sender's own group traffic looped back
+	unsigned char loop = 1;
+	setsockopt(sock, IPPROTO_IP, IP_MULTICAST_LOOP, (const char*)&loop, sizeof(loop));
+
+	typedef std::chrono::steady_clock Clock;
+	const Clock::time_point start = Clock::now();
+	const std::chrono::nanoseconds period(1000000000LL / options.rate);
+	for (size_t i = 0; i < sent.size(); i++)
+	{
+		std::this_thread::sleep_until(start + period * (int64_t)i);
+		sendto(sock, (const char*)sent[i].data(), (int)sent[i].size(), 0, (const sockaddr*)&destination, sizeof(destination));
+	}
+	sending = false;
+
+	for (std::unique_ptr<Subscriber>& subscriber : subscribers)
+		subscriber->thread.join();
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+	closesocket(sock);
+	WSACleanup();
+#else
+	close(sock);
+#endif
+
+	bool passed = true;
+	std::printf("%zu datagrams sent to %s:%d on %s\n", sent.size(), options.group.c_str(), options.port, options.interfaceAddress.c_str());
+	for (size_t r = 0; r < subscribers.size(); r++)
+	{
+		const std::vector<Payload>& received = subscribers[r]->received;
+		size_t matching = 0;
+		while (matching < received.size() && matching < sent.size() && received[matching] == sent[matching])
+			matching++;
+
+		bool ok = matching == sent.size() && received.size() == sent.size();
+		passed = passed && ok;
+		std::printf("receiver %zu: %zu received, %zu in order and intact  %s\n", r, received.size(), matching, ok ? "ok" : "FAILED");
+	}
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,276 @@
+#include "mvnsynthesizer.h"
+#include "packetcapture.h"
+#include "datagramdispatch.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*! Parser microbenchmark
+
+	Decodes synthesized or captured payloads through Datagram::deserialize, one case per protocol,
+	and reports the time and heap allocations per packet. The payloads are built before timing
+	starts and only complete samples are used, so the numbers cover the parser and nothing else.
+*/
+
+// Every heap allocation made by the process, counted by the replaced global operator new
+static std::atomic<uint64_t> g_allocations(0);
+
+void* operator new(size_t size)
+{
+	g_allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+namespace
+{
+	typedef std::vector<uint8_t> Payload;
+
+	struct BenchCase
+	{
+		const char* name;
+		StreamingProtocol protocol;
+		std::unique_ptr<Datagram> (*create)();
+		std::vector<Payload> payloads;
+	};
+
+	template<typename T>
+	std::unique_ptr<Datagram> create()
+	{
+		return std::unique_ptr<Datagram>(new T);
+	}
+
+	struct Result
+	{
+		uint64_t packets;
+		uint64_t bytes;
+		uint64_t allocations;
+		uint64_t failures;
+		double seconds;
+	};
+
+	// Stands in for a consumer reading a few trackers out of every pose it is handed
+	struct PoseSink
+	{
+		float sum = 0.0f;
+
+		void operator()(const QuaternionDatagram& datagram)
+		{
+			for (int segment = 0; segment < 4; segment++)
+				sum += datagram.GetSegmentData((Segment)segment).position[0];
+		}
+		void operator()(const Datagram&) {}
+	};
+
+	/*! Time handing one decoded datagram to \a callback, which is how every datagram leaves ParserManager */
+	double runDispatch(const DatagramCallback& callback, const Datagram& datagram, double minSeconds)
+	{
+		typedef std::chrono::steady_clock Clock;
+		const int Batch = 100000;
+		uint64_t calls = 0;
+		double seconds = 0.0;
+		Clock::time_point start = Clock::now();
+		do {
+			for (int i = 0; i < Batch; i++)
+				callback(SPPoseQuaternion, &datagram);
+			calls += Batch;
+			seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		} while (seconds < minSeconds);
+		return seconds * 1e9 / calls;
+	}
+
+	Result run(BenchCase& bench, double minSeconds, const SegmentIdMask* segments)
+	{
+		typedef std::chrono::steady_clock Clock;
+		std::unique_ptr<Datagram> datagram = bench.create();
+		datagram->setSegmentFilter(segments);
+
+		// One untimed pass, so first touch of the datagram and the payloads is not measured
+		for (const Payload& payload : bench.payloads)
+			datagram->deserialize(payload.data(), payload.size());
+
+		Result result = {};
+		uint64_t allocationsBefore = g_allocations.load(std::memory_order_relaxed);
+		Clock::time_point start = Clock::now();
+		do {
+			for (const Payload& payload : bench.payloads) {
+				if (!datagram->deserialize(payload.data(), payload.size()))
+					result.failures++;
+				result.bytes += payload.size();
+			}
+			result.packets += bench.payloads.size();
+			result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		} while (result.seconds < minSeconds);
+		result.allocations = g_allocations.load(std::memory_order_relaxed) - allocationsBefore;
+		return result;
+	}
+
+	void usage()
+	{
+		std::cout
+			<< "Usage: MVNParserBench [options]\n"
+			<< "  --capture <file>       decode the complete samples of a capture file instead of synthesized ones\n"
+			<< "  --samples <n>          synthesized samples per protocol (240)\n"
+			<< "  --body <n>             body segments (23)\n"
+			<< "  --props <n>            prop segments (0)\n"
+			<< "  --fingers <n>          finger tracking segments (0, MVN sends 40)\n"
+			<< "  --pattern <name>       static, sway, walk or noise (walk)\n"
+			<< "  --segments <list>      decode only these segment IDs, as a tracker mapping would (all)\n"
+			<< "  --time <seconds>       minimum run time of each case (1)\n"
+			<< "  --filter <text>        only run cases whose name contains text\n";
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	MvnSynthesizer::Config config;
+	std::string capturePath;
+	std::string filter;
+	SegmentIdMask segments;
+	int samples = 240;
+	double minSeconds = 1.0;
+
+	// Samples go out whole, the benchmark measures parsing and not reassembly
+	config.maxDatagramSize = 64 * 1024;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		std::string value = i + 1 < argc ? argv[++i] : "";
+
+		if (arg == "--capture") capturePath = value;
+		else if (arg == "--samples") samples = std::stoi(value);
+		else if (arg == "--body") config.bodySegmentCount = std::stoi(value);
+		else if (arg == "--props") config.propCount = std::stoi(value);
+		else if (arg == "--fingers") config.fingerTrackingSegmentCount = std::stoi(value);
+		else if (arg == "--time") minSeconds = std::stod(value);
+		else if (arg == "--filter") filter = value;
+		else if (arg == "--segments") {
+			std::stringstream ss(value);
+			std::string id;
+			while (std::getline(ss, id, ','))
+				segments.set(std::stoi(id));
+		}
+		else if (arg == "--pattern") {
+			if (value == "static") config.pattern = MvnSynthesizer::Static;
+			else if (value == "sway") config.pattern = MvnSynthesizer::Sway;
+			else if (value == "walk") config.pattern = MvnSynthesizer::Walk;
+			else if (value == "noise") config.pattern = MvnSynthesizer::Noise;
+			else { usage(); return 1; }
+		}
+		else {
+			usage();
+			return arg == "--help" ? 0 : 1;
+		}
+	}
+
+	if (samples < 1 || config.bodySegmentCount + config.propCount + config.fingerTrackingSegmentCount > 255) {
+		std::cout << "Need at least one sample and at most 255 segments" << std::endl;
+		return 1;
+	}
+
+	std::vector<BenchCase> cases = {
+		{ "QuaternionDatagram", SPPoseQuaternion, &create<QuaternionDatagram>, {} },
+		{ "Unity3DDatagram", SPPoseUnity3D, &create<Unity3DDatagram>, {} },
+		{ "EulerDatagram", SPPoseEuler, &create<EulerDatagram>, {} },
+		{ "LinearSegmentKinematicsDatagram", SPLinearSegmentKinematics, &create<LinearSegmentKinematicsDatagram>, {} },
+		{ "AngularSegmentKinematicsDatagram", SPAngularSegmentKinematics, &create<AngularSegmentKinematicsDatagram>, {} },
+		{ "TrackerKinematicsDatagram", SPTrackerKinematics, &create<TrackerKinematicsDatagram>, {} },
+		{ "MetaDatagram", SPMetaMoreMeta, &create<MetaDatagram>, {} },
+		{ "ScaleDatagram", SPMetaScaling, &create<ScaleDatagram>, {} },
+		{ "TimeCodeDatagram", SPTimeCode, &create<TimeCodeDatagram>, {} },
+	};
+
+	if (!capturePath.empty())
+	{
+		PacketCaptureReader reader;
+		if (!reader.open(capturePath)) {
+			std::cout << "Failed to open capture file " << capturePath << std::endl;
+			return 1;
+		}
+
+		PacketCaptureReader::Record record;
+		DatagramHeader header;
+		while (reader.next(record))
+		{
+			// Fragments of split samples are left out, Datagram only ever sees reassembled samples
+			if (!DatagramHeader::parse(record.data, record.size, header) || header.datagramCounter != 0x80)
+				continue;
+			for (BenchCase& bench : cases)
+				if (bench.protocol == header.protocol)
+					bench.payloads.emplace_back(record.data, record.data + record.size);
+		}
+	}
+	else
+	{
+		MvnSynthesizer synthesizer(config);
+		for (BenchCase& bench : cases)
+		{
+			MvnSynthesizer::Emit keep = [&bench](const uint8_t* data, size_t size) {
+				bench.payloads.emplace_back(data, data + size);
+			};
+			for (int32_t sample = 0; sample < samples; sample++)
+				synthesizer.sample(bench.protocol, 0, sample, sample / 240.0, keep);
+		}
+	}
+
+	std::printf("%-34s %8s %10s %12s %12s\n", "case", "packets", "ns/packet", "MB/s", "allocs/packet");
+	for (BenchCase& bench : cases)
+	{
+		if (!filter.empty() && std::string(bench.name).find(filter) == std::string::npos)
+			continue;
+		if (bench.payloads.empty()) {
+			std::printf("%-34s %8s\n", bench.name, "no data");
+			continue;
+		}
+
+		Result result = run(bench, minSeconds, segments.empty() ? nullptr : &segments);
+		std::printf("%-34s %8zu %10.1f %12.1f %12.2f\n", bench.name, bench.payloads.size(),
+			result.seconds * 1e9 / result.packets,
+			result.bytes / result.seconds / 1e6,
+			(double)result.allocations / result.packets);
+		if (result.failures)
+			std::printf("%-34s %llu packets failed to decode\n", "", (unsigned long long)result.failures);
+	}
+
+	// The callback alone, a switch and static_cast behind a std::function against a bound visitor
+	if (filter.empty() || std::string("Dispatch").find(filter) != std::string::npos)
+	{
+		MvnSynthesizer synthesizer(config);
+		QuaternionDatagram datagram;
+		synthesizer.sample(SPPoseQuaternion, 0, 0, 0.0, [&datagram](const uint8_t* data, size_t size) {
+			datagram.deserialize(data, size);
+		});
+
+		PoseSink sink;
+		DatagramCallback function = [&sink](StreamingProtocol protocol, const Datagram* datagram) {
+			if (protocol == SPPoseQuaternion)
+				sink(*static_cast<const QuaternionDatagram*>(datagram));
+		};
+		DatagramCallback visitor = DatagramCallback::visitor(sink);
+
+		std::printf("\n%-34s %10s\n", "dispatch", "ns/packet");
+		std::printf("%-34s %10.2f\n", "std::function", runDispatch(function, datagram, minSeconds));
+		std::printf("%-34s %10.2f\n", "visitor", runDispatch(visitor, datagram, minSeconds));
+	}
+	return 0;
+}
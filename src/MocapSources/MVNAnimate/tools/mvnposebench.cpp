@@ -0,0 +1,267 @@
+#include "segments.h"
+#include "PosePublisher.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*! Pose publication under contention
+
+	A writer thread publishes a full pose at the MVN rate while tracker threads read it at the
+	headset rate, the way the receive thread and RunFrame share an avatar's pose. It is run once
+	with the mutex and copy GetNextPose used to do and once with PosePublisher, for a range of
+	tracker counts. Reported are the time all trackers of a frame spend reading, the time one
+	publish takes the writer, and the heap allocations per frame.
+*/
+
+// Every heap allocation made by the process, counted by the replaced global operator new
+static std::atomic<uint64_t> g_allocations(0);
+
+void* operator new(size_t size)
+{
+	g_allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	struct Options
+	{
+		int writerRate = 240;
+		int frameRate = 144;
+		int threads = 1;
+		double seconds = 2.0;
+	};
+
+	// The old path: the writer fills the pose under a mutex, every reader copy constructs it under the same mutex
+	struct LockedPose
+	{
+		static constexpr const char* Name = "mutex";
+
+		std::mutex mutex;
+		PoseSample pose{};
+
+		template<typename Fill>
+		void write(Fill fill)
+		{
+			std::scoped_lock<std::mutex> lock(mutex);
+			fill(pose);
+		}
+
+		struct Reader
+		{
+			PoseSample read(LockedPose& source)
+			{
+				std::scoped_lock<std::mutex> lock(source.mutex);
+				return PoseSample(source.pose);
+			}
+		};
+	};
+
+	struct PublishedPose
+	{
+		static constexpr const char* Name = "seqlock";
+
+		PosePublisher publisher;
+
+		template<typename Fill>
+		void write(Fill fill)
+		{
+			fill(publisher.BeginWrite());
+			publisher.EndWrite();
+		}
+
+		struct Reader
+		{
+			PoseSample pose{};
+
+			const PoseSample& read(PublishedPose& source)
+			{
+				source.publisher.Read(pose);
+				return pose;
+			}
+		};
+	};
+
+	struct Stats
+	{
+		std::vector<uint64_t> ns;
+
+		uint64_t percentile(double fraction)
+		{
+			if (ns.empty())
+				return 0;
+			std::sort(ns.begin(), ns.end());
+			return ns[std::min(ns.size() - 1, (size_t)(fraction * ns.size()))];
+		}
+	};
+
+	uint64_t elapsedNs(Clock::time_point start)
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+	}
+
+	template<typename Source>
+	void run(int trackers, const Options& options)
+	{
+		Source source;
+		std::atomic_bool stop(false);
+		Clock::time_point end = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.seconds));
+
+		// Reserved up front, so the allocations counted are those of the reads
+		Stats publishes;
+		publishes.ns.reserve((size_t)(options.writerRate * options.seconds) + 64);
+		std::thread writer([&]() {
+			const std::chrono::nanoseconds period(1000000000LL / options.writerRate);
+			Clock::time_point next = Clock::now();
+			for (int32_t sample = 1; !stop; sample++)
+			{
+				std::this_thread::sleep_until(next);
+				next += period;
+
+				Clock::time_point start = Clock::now();
+				source.write([sample](PoseSample& pose) {
+					for (int segment = 0; segment < (int)SegmentName.size(); segment++) {
+						for (int i = 0; i < 3; i++)
+							pose.translation[i][segment] = (float)sample;
+						for (int i = 0; i < 4; i++)
+							pose.rotation_quat[i][segment] = (float)sample;
+						for (int i = 0; i < 3; i++)
+							pose.velocity[i][segment] = (float)sample;
+						pose.SetValid(segment);
+					}
+					pose.pose_id = sample;
+				});
+				publishes.ns.push_back(elapsedNs(start));
+			}
+		});
+
+		// Trackers are split over the reader threads, one thread is RunFrame updating every device in turn
+		int threadCount = std::max(1, std::min(options.threads, trackers));
+		std::vector<Stats> frames(threadCount);
+		for (Stats& stats : frames)
+			stats.ns.reserve((size_t)(options.frameRate * options.seconds) + 64);
+		std::atomic<uint64_t> torn(0);
+		std::atomic<uint64_t> frameCount(0);
+		uint64_t allocationsBefore = g_allocations.load(std::memory_order_relaxed);
+
+		std::vector<std::thread> readers;
+		for (int t = 0; t < threadCount; t++)
+		{
+			int count = trackers / threadCount + (t < trackers % threadCount ? 1 : 0);
+			readers.emplace_back([&, t, count]() {
+				// One read buffer per thread, as RunFrame keeps one snapshot per actor
+				typename Source::Reader reader;
+				const std::chrono::nanoseconds period(1000000000LL / options.frameRate);
+				Clock::time_point next = Clock::now();
+				double sink = 0.0;
+
+				while (Clock::now() < end)
+				{
+					std::this_thread::sleep_until(next);
+					next += period;
+
+					Clock::time_point start = Clock::now();
+					for (int i = 0; i < count; i++)
+					{
+						const PoseSample& pose = reader.read(source);
+						int segment = i % (int)SegmentName.size();
+
+						// A pose mixing two samples would show up as segments disagreeing with pose_id
+						if (pose.pose_id && (pose.translation[0][segment] != (float)pose.pose_id || pose.velocity[2][segment] != (float)pose.pose_id))
+							torn++;
+						sink += pose.translation[0][segment];
+					}
+					frames[t].ns.push_back(elapsedNs(start));
+					frameCount++;
+				}
+				if (sink < 0.0)
+					std::cout << sink;
+			});
+		}
+
+		for (std::thread& reader : readers)
+			reader.join();
+		stop = true;
+		writer.join();
+
+		uint64_t allocations = g_allocations.load(std::memory_order_relaxed) - allocationsBefore;
+		Stats frame;
+		for (Stats& stats : frames)
+			frame.ns.insert(frame.ns.end(), stats.ns.begin(), stats.ns.end());
+
+		std::printf("%-8s %8d %10llu %10llu %10llu %10llu %10llu %10.1f %6llu\n", Source::Name, trackers,
+			(unsigned long long)frame.percentile(0.5), (unsigned long long)frame.percentile(0.99),
+			(unsigned long long)frame.percentile(1.0), (unsigned long long)publishes.percentile(0.99),
+			(unsigned long long)publishes.percentile(1.0),
+			frameCount ? (double)allocations / frameCount : 0.0, (unsigned long long)torn.load());
+	}
+
+	void usage()
+	{
+		std::cout
+			<< "Usage: MVNPoseBench [options]\n"
+			<< "  --writer-rate <hz>     pose publish rate (240)\n"
+			<< "  --frame-rate <hz>      tracker read rate (144)\n"
+			<< "  --threads <n>          reader threads the trackers are split over (1)\n"
+			<< "  --seconds <s>          run time per case (2)\n";
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	Options options;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		std::string value = i + 1 < argc ? argv[++i] : "";
+
+		if (arg == "--writer-rate") options.writerRate = std::stoi(value);
+		else if (arg == "--frame-rate") options.frameRate = std::stoi(value);
+		else if (arg == "--threads") options.threads = std::stoi(value);
+		else if (arg == "--seconds") options.seconds = std::stod(value);
+		else {
+			usage();
+			return arg == "--help" ? 0 : 1;
+		}
+	}
+
+	if (options.writerRate < 1 || options.frameRate < 1 || options.threads < 1 || options.seconds <= 0.0) {
+		usage();
+		return 1;
+	}
+
+	std::printf("%d segment pose written at %d Hz, read by every tracker at %d Hz on %d thread(s), times in ns\n",
+		(int)SegmentName.size(), options.writerRate, options.frameRate, options.threads);
+	std::printf("%-8s %8s %10s %10s %10s %10s %10s %10s %6s\n",
+		"publish", "trackers", "frame p50", "frame p99", "frame max", "write p99", "write max", "allocs/fr", "torn");
+	for (int trackers : { 8, 16, 32, 64 })
+	{
+		run<LockedPose>(trackers, options);
+		run<PublishedPose>(trackers, options);
+	}
+	return 0;
+}
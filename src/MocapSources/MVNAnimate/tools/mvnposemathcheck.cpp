@@ -0,0 +1,131 @@
+#include <linalg.h>
+#include <PoseMath.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+
+/*! Axis swizzles against the matrix path
+
+	The constexpr conversions in PoseMath.hpp replace building a pose matrix, changing its basis
+	with ConvertZtoYUp and extracting the quaternion again. This runs both on random poses and
+	fails if any component differs by more than the tolerance, so a change to either side that
+	breaks the equivalence shows up. Run it after touching the coordinate conversions.
+*/
+
+namespace
+{
+	typedef linalg::vec<float, 3> Vec3;
+	typedef linalg::vec<float, 4> Quat;
+
+	// Checked when this file compiles: the swizzles are constant expressions with the expected order
+	static_assert(ConvertZtoYUp(Vec3{ 1, 2, 3 }).x == 2 && ConvertZtoYUp(Vec3{ 1, 2, 3 }).y == 3
+		&& ConvertZtoYUp(Vec3{ 1, 2, 3 }).z == 1, "Z-up to Y-up cycles (x, y, z) to (y, z, x)");
+	static_assert(ConvertZtoYUpQuat(Quat{ 1, 2, 3, 4 }).x == 2 && ConvertZtoYUpQuat(Quat{ 1, 2, 3, 4 }).y == 3
+		&& ConvertZtoYUpQuat(Quat{ 1, 2, 3, 4 }).z == 1 && ConvertZtoYUpQuat(Quat{ 1, 2, 3, 4 }).w == 4,
+		"Z-up to Y-up cycles the vector part of a quaternion and keeps its real part");
+	static_assert(ConvertUnityToYUp(Vec3{ 1, 2, 3 }).x == -1 && ConvertUnityToYUp(Vec3{ 1, 2, 3 }).y == 2
+		&& ConvertUnityToYUp(Vec3{ 1, 2, 3 }).z == 3, "Unity3D to OpenVR mirrors x");
+	static_assert(ConvertUnityToYUpQuat(Quat{ 1, 2, 3, 4 }).x == 1 && ConvertUnityToYUpQuat(Quat{ 1, 2, 3, 4 }).y == -2
+		&& ConvertUnityToYUpQuat(Quat{ 1, 2, 3, 4 }).z == -3 && ConvertUnityToYUpQuat(Quat{ 1, 2, 3, 4 }).w == 4,
+		"Unity3D to OpenVR keeps x of a quaternion and negates y and z");
+
+	struct Check
+	{
+		const char* name;
+		double maxError = 0.0;
+
+		void compare(const Vec3& expected, const Vec3& actual)
+		{
+			for (int i = 0; i < 3; i++)
+				maxError = std::max(maxError, (double)std::fabs(expected[i] - actual[i]));
+		}
+
+		// q and -q are the same rotation, the matrix path may return either
+		void compareRotation(const Quat& expected, const Quat& actual)
+		{
+			float sign = linalg::dot(expected, actual) < 0.0f ? -1.0f : 1.0f;
+			for (int i = 0; i < 4; i++)
+				maxError = std::max(maxError, (double)std::fabs(expected[i] - sign * actual[i]));
+		}
+	};
+
+	void usage()
+	{
+		std::cout
+			<< "Usage: MVNPoseMathCheck [options]\n"
+			<< "  --count <n>            random poses to compare (100000)\n"
+			<< "  --seed <n>             random seed (1)\n"
+			<< "  --tolerance <x>        largest accepted difference per component (1e-5)\n";
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	int count = 100000;
+	unsigned seed = 1;
+	double tolerance = 1e-5;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		std::string value = i + 1 < argc ? argv[++i] : "";
+
+		if (arg == "--count") count = std::stoi(value);
+		else if (arg == "--seed") seed = (unsigned)std::stoul(value);
+		else if (arg == "--tolerance") tolerance = std::stod(value);
+		else {
+			usage();
+			return arg == "--help" ? 0 : 1;
+		}
+	}
+
+	std::mt19937 random(seed);
+	std::normal_distribution<float> normal(0.0f, 1.0f);
+	std::uniform_real_distribution<float> distance(-10.0f, 10.0f);
+
+	Check rotation{ "Z-up rotation" };
+	Check position{ "Z-up position" };
+	Check vector{ "Z-up vector" };
+	Check unityRotation{ "Unity3D rotation" };
+	Check unityPosition{ "Unity3D position" };
+
+	for (int i = 0; i < count; i++)
+	{
+		// Normalized gaussian samples are uniformly distributed rotations
+		Quat q = linalg::normalize(Quat{ normal(random), normal(random), normal(random), normal(random) });
+		Vec3 p{ distance(random), distance(random), distance(random) };
+		Vec3 v{ distance(random), distance(random), distance(random) };
+
+		// The matrix path the driver used to take for every segment
+		linalg::mat<float, 4, 4> converted = ConvertZtoYUp(linalg::pose_matrix(q, p));
+		Quat matrixRotation = linalg::rotation_quat(GetRotationMatrixFromTransform(converted));
+		Vec3 matrixPosition{ converted.w.x, converted.w.y, converted.w.z };
+
+		rotation.compareRotation(matrixRotation, ConvertZtoYUpQuat(q));
+		position.compare(matrixPosition, ConvertZtoYUp(p));
+
+		// A free vector changes basis like a translation without a rotation
+		linalg::mat<float, 4, 4> translated = ConvertZtoYUp(linalg::pose_matrix(Quat{ 0, 0, 0, 1 }, v));
+		vector.compare(Vec3{ translated.w.x, translated.w.y, translated.w.z }, ConvertZtoYUp(v));
+
+		// The same pose as MVN streams it in Unity3D, position (-y, z, x) and quaternion (w, y, -z, -x)
+		Vec3 unityP{ -p.y, p.z, p.x };
+		Quat unityQ{ q.y, -q.z, -q.x, q.w };
+		unityRotation.compareRotation(matrixRotation, ConvertUnityToYUpQuat(unityQ));
+		unityPosition.compare(matrixPosition, ConvertUnityToYUp(unityP));
+	}
+
+	bool passed = true;
+	std::printf("%d random poses, tolerance %g\n", count, tolerance);
+	for (const Check* check : { &rotation, &position, &vector, &unityRotation, &unityPosition })
+	{
+		bool ok = check->maxError <= tolerance;
+		passed = passed && ok;
+		std::printf("%-18s max error %.3g  %s\n", check->name, check->maxError, ok ? "ok" : "FAILED");
+	}
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,230 @@
+#include "udpreceiver.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET SocketHandle;
+#elif defined(__linux) || defined(__linux__) || defined(linux)
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+typedef int SocketHandle;
+#endif
+
+/*! Receive latency and throughput of the old polling loop against UdpReceiver
+
+	A sender thread stamps small datagrams with the time they leave and sends them over loopback at
+	a steady rate. The poll mode is the loop UdpServer ran before UdpReceiver: one non-blocking read,
+	then a 1 ms sleep whether or not a datagram was there. The block mode waits in
+	UdpReceiver::receive and drains the batch. For both, the time from send to the datagram being
+	read is collected, and the rate column shows how many datagrams per second were read.
+
+	With --burst, several datagrams leave per tick as MVN sends one per protocol per sample, which
+	is where reading one datagram per millisecond falls behind.
+*/
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	struct Options
+	{
+		uint16_t port = 9764;
+		int count = 2000;
+		int rate = 240;
+		int burst = 1;
+	};
+
+	uint64_t nowNs()
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+	}
+
+	void closeSocket(SocketHandle sock)
+	{
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+		closesocket(sock);
+#else
+		close(sock);
+#endif
+	}
+
+	void send(const Options& options, std::atomic_bool& stop)
+	{
+		SocketHandle sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		sockaddr_in destination = {};
+		destination.sin_family = AF_INET;
+		destination.sin_port = htons(options.port);
+		inet_pton(AF_INET, "127.0.0.1", &destination.sin_addr);
+
+		const std::chrono::nanoseconds period(1000000000LL / options.rate);
+		Clock::time_point next = Clock::now();
+		while (!stop)
+		{
+			std::this_thread::sleep_until(next);
+			next += period;
+
+			for (int i = 0; i < options.burst; i++)
+			{
+				uint64_t sent = nowNs();
+				sendto(sock, (const char*)&sent, sizeof(sent), 0, (const sockaddr*)&destination, sizeof(destination));
+			}
+		}
+
+		closeSocket(sock);
+	}
+
+	// A non-blocking socket on the loopback port, what the polling loop read from
+	bool openPollSocket(uint16_t port, SocketHandle& sock)
+	{
+		sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		sockaddr_in local = {};
+		local.sin_family = AF_INET;
+		local.sin_port = htons(port);
+		inet_pton(AF_INET, "127.0.0.1", &local.sin_addr);
+		if (bind(sock, (const sockaddr*)&local, sizeof(local)) != 0) {
+			closeSocket(sock);
+			return false;
+		}
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+		u_long nonBlocking = 1;
+		ioctlsocket(sock, FIONBIO, &nonBlocking);
+#else
+		fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+#endif
+		return true;
+	}
+
+	void run(bool poll, const Options& options)
+	{
+		UdpReceiver receiver;
+		SocketHandle pollSocket = 0;
+		bool bound = poll ? openPollSocket(options.port, pollSocket) : receiver.bind("127.0.0.1", options.port);
+		if (!bound) {
+			std::cout << "Failed to bind port " << options.port << std::endl;
+			return;
+		}
+
+		std::vector<double> samples;
+		samples.reserve(options.count);
+		Clock::time_point first, last;
+
+		auto record = [&](const uint8_t* data, uint64_t received) {
+			uint64_t sent;
+			memcpy(&sent, data, sizeof(sent));
+			samples.push_back((received - sent) / 1000.0);
+			last = Clock::now();
+			if (samples.size() == 1)
+				first = last;
+		};
+
+		std::atomic_bool stop(false);
+		std::thread sendThread(send, std::cref(options), std::ref(stop));
+
+		if (poll) {
+			uint8_t buffer[64];
+			while ((int)samples.size() < options.count)
+			{
+				if (recv(pollSocket, (char*)buffer, sizeof(buffer), 0) >= (int)sizeof(uint64_t))
+					record(buffer, nowNs());
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		}
+		else {
+			DatagramBatch batch;
+			while ((int)samples.size() < options.count)
+			{
+				if (receiver.receive(batch, 1000) == 0)
+					continue;
+				uint64_t received = nowNs();
+				for (size_t i = 0; i < batch.count() && (int)samples.size() < options.count; i++)
+					record(batch.data(i), received);
+			}
+		}
+
+		stop = true;
+		sendThread.join();
+		if (poll)
+			closeSocket(pollSocket);
+
+		double mean = 0.0;
+		for (double sample : samples)
+			mean += sample;
+		mean /= samples.size();
+		double variance = 0.0;
+		for (double sample : samples)
+			variance += (sample - mean) * (sample - mean);
+		double stddev = std::sqrt(variance / samples.size());
+		double seconds = std::chrono::duration<double>(last - first).count();
+
+		std::sort(samples.begin(), samples.end());
+		auto percentile = [&](double p) { return samples[std::min(samples.size() - 1, (size_t)(p * samples.size()))]; };
+
+		std::printf("%-6s %10.1f %10.1f %10.1f %10.1f %10.1f %8.0f\n", poll ? "poll" : "block", mean, stddev,
+			percentile(0.5), percentile(0.99), samples.back(), seconds > 0.0 ? (samples.size() - 1) / seconds : 0.0);
+	}
+
+	void usage()
+	{
+		std::cout
+			<< "Usage: MVNReceiveBench [options]\n"
+			<< "  --port <port>          loopback port to use (9764)\n"
+			<< "  --count <n>            datagrams per mode (2000)\n"
+			<< "  --rate <hz>            send rate (240)\n"
+			<< "  --burst <n>            datagrams sent per tick (1)\n";
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	Options options;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		std::string value = i + 1 < argc ? argv[++i] : "";
+
+		if (arg == "--port") options.port = (uint16_t)std::stoi(value);
+		else if (arg == "--count") options.count = std::stoi(value);
+		else if (arg == "--rate") options.rate = std::stoi(value);
+		else if (arg == "--burst") options.burst = std::stoi(value);
+		else {
+			usage();
+			return arg == "--help" ? 0 : 1;
+		}
+	}
+
+	if (options.count < 1 || options.rate < 1 || options.burst < 1) {
+		usage();
+		return 1;
+	}
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+	WSADATA wsaData;
+	WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+
+	std::printf("Send to read in us, %d datagrams at %d Hz x %d per mode, rate in datagrams/s\n", options.count, options.rate, options.burst);
+	std::printf("%-6s %10s %10s %10s %10s %10s %8s\n", "mode", "mean", "stddev", "p50", "p99", "max", "rate");
+	run(true, options);
+	run(false, options);
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+	WSACleanup();
+#endif
+	return 0;
+}
@@ -0,0 +1,316 @@
+#include "streamer.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/*! Streamer microbenchmark
+
+	Decodes the 24 byte header and the segment records of quaternion payloads field by field, once
+	with a copy of the Streamer the parser used to have and once with the current one, and reports
+	the time and heap allocations per packet. Both decoders have to agree on every field.
+*/
+
+// Every heap allocation made by the process, counted by the replaced global operator new
+static std::atomic<uint64_t> g_allocations(0);
+
+void* operator new(size_t size)
+{
+	g_allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+namespace
+{
+	typedef std::vector<uint8_t> Payload;
+
+	/*! The Streamer before it became a view: it references the array the socket filled, checks the
+		host order at run time and reassembles every field byte by byte
+	*/
+	class LegacyStreamer
+	{
+	public:
+		LegacyStreamer(const Payload& arr)
+			: m_array(&arr)
+			, m_offset(0)
+		{
+			int num = 1;
+			m_littleEndian = *(char *)&num == 1;
+		}
+
+		void read(int32_t &destination)
+		{
+			char byte_array[4];
+			memcpy(byte_array, m_array->data() + m_offset, sizeof(destination));
+			if (m_littleEndian)
+				destination = (byte_array[0] << 24) | ((byte_array[1] & 0xff) << 16) | ((byte_array[2] & 0xff) << 8) | (byte_array[3] & 0xff);
+			else
+				destination = (byte_array[3] << 24) | ((byte_array[2] & 0xff) << 16) | ((byte_array[1] & 0xff) << 8) | (byte_array[0] & 0xff);
+			m_offset += 4;
+		}
+
+		void read(uint16_t &destination)
+		{
+			uint8_t byte_array[2];
+			memcpy(byte_array, m_array->data() + m_offset, 2);
+			if (m_littleEndian)
+				destination = ((byte_array[0] & 0xff) << 8) | (byte_array[1] & 0xff);
+			else
+				destination = ((byte_array[1] & 0xff) << 8) | (byte_array[0] & 0xff);
+			m_offset += 2;
+		}
+
+		void read(uint8_t &destination)
+		{
+			memcpy(&destination, m_array->data() + m_offset, 1);
+			m_offset++;
+		}
+
+		void read(float &destination)
+		{
+			float output = 0.0;
+			unsigned char byte_array[4];
+			memcpy(&byte_array, m_array->data() + m_offset, sizeof(destination));
+			if (m_littleEndian)
+			{
+				*((unsigned char*)(&output) + 3) = byte_array[0];
+				*((unsigned char*)(&output) + 2) = byte_array[1];
+				*((unsigned char*)(&output) + 1) = byte_array[2];
+				*((unsigned char*)(&output) + 0) = byte_array[3];
+			}
+			else
+			{
+				*((unsigned char*)(&output) + 3) = byte_array[3];
+				*((unsigned char*)(&output) + 2) = byte_array[2];
+				*((unsigned char*)(&output) + 1) = byte_array[1];
+				*((unsigned char*)(&output) + 0) = byte_array[0];
+			}
+			destination = output;
+			m_offset += 4;
+		}
+
+		void read(std::string& str, int numChars)
+		{
+			char * buffer = new char[numChars + 1];
+			memcpy(buffer, m_array->data() + m_offset, numChars);
+			buffer[numChars] = '\0';
+			str = buffer;
+			delete[] buffer;
+			m_offset += numChars;
+		}
+
+	private:
+		const Payload* m_array;
+		int m_offset;
+		bool m_littleEndian;
+	};
+
+	// The fields of the 24 byte header and of one quaternion segment record
+	struct DecodedHeader
+	{
+		std::string messageType;
+		int32_t sampleCounter;
+		uint8_t datagramCounter, dataCount;
+		int32_t frameTime;
+		uint8_t avatarId, bodySegmentCount, propCount, fingerTrackingSegmentCount, reserved[2];
+		uint16_t dataSize;
+	};
+
+	struct SegmentRecord
+	{
+		int32_t segmentId;
+		float fields[7];
+	};
+
+	const size_t HeaderSize = 24;
+	const size_t SegmentRecordSize = 32;
+
+	// Field for field what Datagram::deserialize and QuaternionDatagram::deserializeData read
+	template<typename Reader>
+	void decodeFields(Reader& streamer, DecodedHeader& header, std::vector<SegmentRecord>& records)
+	{
+		streamer.read(header.messageType, 6);
+		streamer.read(header.sampleCounter);
+		streamer.read(header.datagramCounter);
+		streamer.read(header.dataCount);
+		streamer.read(header.frameTime);
+		streamer.read(header.avatarId);
+		streamer.read(header.bodySegmentCount);
+		streamer.read(header.propCount);
+		streamer.read(header.fingerTrackingSegmentCount);
+		streamer.read(header.reserved[0]);
+		streamer.read(header.reserved[1]);
+		streamer.read(header.dataSize);
+
+		for (SegmentRecord& record : records) {
+			streamer.read(record.segmentId);
+			if constexpr (std::is_same<Reader, Streamer>::value)
+				streamer.read(record.fields, 7);
+			else
+				for (int k = 0; k < 7; k++)
+					streamer.read(record.fields[k]);
+		}
+	}
+
+	void putBigEndian(Payload& payload, uint32_t value, size_t bytes)
+	{
+		for (size_t i = bytes; i-- > 0;)
+			payload.push_back((uint8_t)(value >> (8 * i)));
+	}
+
+	void putFloat(Payload& payload, float value)
+	{
+		uint32_t raw;
+		memcpy(&raw, &value, sizeof(raw));
+		putBigEndian(payload, raw, 4);
+	}
+
+	/*! A quaternion payload as MVN sends it, with a slowly turning pose so no two are the same */
+	Payload buildPayload(int sample, int segmentCount)
+	{
+		Payload payload;
+		payload.reserve(HeaderSize + segmentCount * SegmentRecordSize);
+		const char* messageType = "MXTP02";
+		payload.insert(payload.end(), messageType, messageType + 6);
+		putBigEndian(payload, (uint32_t)sample, 4);
+		putBigEndian(payload, 0x80, 1);
+		putBigEndian(payload, (uint32_t)segmentCount, 1);
+		putBigEndian(payload, (uint32_t)(sample * 4), 4);
+		putBigEndian(payload, 1, 1);
+		putBigEndian(payload, (uint32_t)std::min(segmentCount, 23), 1);
+		putBigEndian(payload, 0, 1);
+		putBigEndian(payload, (uint32_t)std::max(segmentCount - 23, 0), 1);
+		putBigEndian(payload, 0, 2);
+		putBigEndian(payload, (uint32_t)(segmentCount * SegmentRecordSize), 2);
+
+		for (int s = 0; s < segmentCount; s++)
+		{
+			float angle = 0.01f * sample + 0.1f * s;
+			putBigEndian(payload, (uint32_t)(s + 1), 4);
+			putFloat(payload, 0.1f * s);
+			putFloat(payload, 0.05f * s);
+			putFloat(payload, 1.0f + 0.02f * s);
+			putFloat(payload, std::cos(angle));
+			putFloat(payload, std::sin(angle));
+			putFloat(payload, 0.0f);
+			putFloat(payload, 0.0f);
+		}
+		return payload;
+	}
+
+	/*! Time \a decode over all \a payloads, in ns per packet, and count the allocations */
+	template<typename Decode>
+	double run(const std::vector<Payload>& payloads, double minSeconds, double& allocations, Decode decode)
+	{
+		typedef std::chrono::steady_clock Clock;
+		for (const Payload& payload : payloads)
+			decode(payload);
+
+		uint64_t count = 0;
+		double seconds = 0.0;
+		uint64_t allocationsBefore = g_allocations.load(std::memory_order_relaxed);
+		Clock::time_point start = Clock::now();
+		do {
+			for (const Payload& payload : payloads)
+				decode(payload);
+			count += payloads.size();
+			seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		} while (seconds < minSeconds);
+		allocations = (double)(g_allocations.load(std::memory_order_relaxed) - allocationsBefore) / count;
+		return seconds * 1e9 / count;
+	}
+
+	void usage()
+	{
+		std::cout
+			<< "Usage: MVNStreamerBench [options]\n"
+			<< "  --samples <n>          payloads to decode (240)\n"
+			<< "  --segments <n>         segment records per payload (23)\n"
+			<< "  --time <s>             minimum time per case (1)\n";
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	int samples = 240;
+	int segmentCount = 23;
+	double minSeconds = 1.0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		std::string value = i + 1 < argc ? argv[++i] : "";
+
+		if (arg == "--samples") samples = std::stoi(value);
+		else if (arg == "--segments") segmentCount = std::stoi(value);
+		else if (arg == "--time") minSeconds = std::stod(value);
+		else {
+			usage();
+			return arg == "--help" ? 0 : 1;
+		}
+	}
+
+	if (samples < 1 || segmentCount < 1 || segmentCount > 255) {
+		usage();
+		return 1;
+	}
+
+	std::vector<Payload> payloads;
+	for (int sample = 0; sample < samples; sample++)
+		payloads.push_back(buildPayload(sample, segmentCount));
+
+	DecodedHeader legacyHeader, viewHeader;
+	std::vector<SegmentRecord> legacy(segmentCount), view(segmentCount);
+	bool agree = true;
+	for (const Payload& payload : payloads)
+	{
+		LegacyStreamer legacyStreamer(payload);
+		decodeFields(legacyStreamer, legacyHeader, legacy);
+		Streamer streamer(payload.data(), payload.size());
+		decodeFields(streamer, viewHeader, view);
+
+		agree = agree && legacyHeader.messageType == viewHeader.messageType && legacyHeader.sampleCounter == viewHeader.sampleCounter
+			&& legacyHeader.frameTime == viewHeader.frameTime && legacyHeader.dataSize == viewHeader.dataSize;
+		for (int i = 0; i < segmentCount; i++)
+			agree = agree && legacy[i].segmentId == view[i].segmentId && memcmp(legacy[i].fields, view[i].fields, sizeof(view[i].fields)) == 0;
+	}
+
+	double legacyAllocations, viewAllocations;
+	double legacyNs = run(payloads, minSeconds, legacyAllocations, [&](const Payload& payload) {
+		LegacyStreamer streamer(payload);
+		decodeFields(streamer, legacyHeader, legacy);
+	});
+	double viewNs = run(payloads, minSeconds, viewAllocations, [&](const Payload& payload) {
+		Streamer streamer(payload.data(), payload.size());
+		decodeFields(streamer, viewHeader, view);
+	});
+
+	std::printf("%-22s %10s %14s  %d segments per packet\n", "streamer", "ns/packet", "allocs/packet", segmentCount);
+	std::printf("%-22s %10.1f %14.2f\n", "byte shuffle (old)", legacyNs, legacyAllocations);
+	std::printf("%-22s %10.1f %14.2f\n", "view + bswap", viewNs, viewAllocations);
+	if (!agree) {
+		std::cout << "Decoded values differ" << std::endl;
+		return 1;
+	}
+	return 0;
+}
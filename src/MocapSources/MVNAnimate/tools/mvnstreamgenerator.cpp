@@ -0,0 +1,171 @@
+#include "mvnsynthesizer.h"
+
+#include <chrono>
+#include <thread>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET SocketHandle;
+#elif defined(__linux) || defined(__linux__) || defined(linux)
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+typedef int SocketHandle;
+#endif
+
+/*! Synthetic MVN stream for load and soak testing without a suit
+
+	Every tick sends one sample of each pose protocol for every avatar. Meta data and the null
+	pose are repeated once a second, as MVN does, so a receiver that starts late still gets them.
+*/
+
+static void usage()
+{
+	std::cout
+		<< "Usage: MVNStreamGenerator [options]\n"
+		<< "  --host <ip>            destination address (127.0.0.1)\n"
+		<< "  --port <port>          destination port (9763)\n"
+		<< "  --interface <ip>       interface to send multicast through, e.g. 127.0.0.1 (routing table)\n"
+		<< "  --avatars <n>          number of avatars (1)\n"
+		<< "  --body <n>             body segments per avatar (23)\n"
+		<< "  --props <n>            prop segments per avatar (0)\n"
+		<< "  --fingers <n>          finger tracking segments per avatar (0, MVN sends 40)\n"
+		<< "  --rate <hz>            sample rate, 60 to 1000 (240)\n"
+		<< "  --mtu <bytes>          largest datagram, bigger samples are fragmented (1500)\n"
+		<< "  --pattern <name>       static, sway, walk or noise (walk)\n"
+		<< "  --protocols <list>     pose protocols as hex codes (02,21,22)\n"
+		<< "  --duration <seconds>   stop after this long, 0 runs until killed (0)\n";
+}
+
+static std::vector<StreamingProtocol> parseProtocols(const std::string& list)
+{
+	std::vector<StreamingProtocol> protocols;
+	std::stringstream ss(list);
+	std::string code;
+	while (std::getline(ss, code, ','))
+		protocols.push_back((StreamingProtocol)std::stoi(code, nullptr, 16));
+	return protocols;
+}
+
+int main(int argc, char *argv[])
+{
+	MvnSynthesizer::Config config;
+	std::string host = "127.0.0.1";
+	std::string multicastInterface;
+	int port = 9763;
+	int rate = 240;
+	double duration = 0.0;
+	std::vector<StreamingProtocol> protocols = { SPPoseQuaternion, SPLinearSegmentKinematics, SPAngularSegmentKinematics };
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		std::string value = i + 1 < argc ? argv[++i] : "";
+
+		if (arg == "--host") host = value;
+		else if (arg == "--port") port = std::stoi(value);
+		else if (arg == "--interface") multicastInterface = value;
+		else if (arg == "--avatars") config.avatarCount = std::stoi(value);
+		else if (arg == "--body") config.bodySegmentCount = std::stoi(value);
+		else if (arg == "--props") config.propCount = std::stoi(value);
+		else if (arg == "--fingers") config.fingerTrackingSegmentCount = std::stoi(value);
+		else if (arg == "--rate") rate = std::stoi(value);
+		else if (arg == "--mtu") config.maxDatagramSize = (size_t)std::stoul(value);
+		else if (arg == "--protocols") protocols = parseProtocols(value);
+		else if (arg == "--duration") duration = std::stod(value);
+		else if (arg == "--pattern") {
+			if (value == "static") config.pattern = MvnSynthesizer::Static;
+			else if (value == "sway") config.pattern = MvnSynthesizer::Sway;
+			else if (value == "walk") config.pattern = MvnSynthesizer::Walk;
+			else if (value == "noise") config.pattern = MvnSynthesizer::Noise;
+			else { usage(); return 1; }
+		}
+		else {
+			usage();
+			return arg == "--help" ? 0 : 1;
+		}
+	}
+
+	if (rate < 60) rate = 60;
+	if (rate > 1000) rate = 1000;
+	if (config.avatarCount < 1 || config.avatarCount > 256 || config.bodySegmentCount + config.propCount + config.fingerTrackingSegmentCount > 255) {
+		std::cout << "Avatar count must be 1 to 256 and every avatar at most 255 segments" << std::endl;
+		return 1;
+	}
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+	WSADATA wsaData;
+	WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+
+	SocketHandle sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	sockaddr_in destination = {};
+	destination.sin_family = AF_INET;
+	destination.sin_port = htons((uint16_t)port);
+	inet_pton(AF_INET, host.c_str(), &destination.sin_addr);
+
+	// A multicast group is reached through the default route unless an interface is picked
+	if (!multicastInterface.empty()) {
+		in_addr outgoing = {};
+		inet_pton(AF_INET, multicastInterface.c_str(), &outgoing);
+		setsockopt(sock, IPPROTO_IP, IP_MULTICAST_IF, (const char*)&outgoing, sizeof(outgoing));
+	}
+
+	uint64_t datagrams = 0;
+	uint64_t bytes = 0;
+	MvnSynthesizer synthesizer(config);
+	MvnSynthesizer::Emit send = [&](const uint8_t* data, size_t size) {
+		sendto(sock, (const char*)data, (int)size, 0, (const sockaddr*)&destination, sizeof(destination));
+		datagrams++;
+		bytes += size;
+	};
+
+	std::cout << "Streaming " << config.avatarCount << " avatar(s) of " << synthesizer.segmentCount()
+		<< " segments at " << rate << " Hz to " << host << ":" << port << std::endl;
+
+	typedef std::chrono::steady_clock Clock;
+	const Clock::time_point start = Clock::now();
+	const std::chrono::nanoseconds period(1000000000LL / rate);
+	Clock::time_point nextReport = start + std::chrono::seconds(1);
+
+	for (int32_t sample = 0; ; sample++)
+	{
+		Clock::time_point tick = start + period * sample;
+		std::this_thread::sleep_until(tick);
+
+		double t = std::chrono::duration<double>(tick - start).count();
+		if (duration > 0.0 && t >= duration)
+			break;
+
+		for (int avatar = 0; avatar < config.avatarCount; avatar++)
+		{
+			if (sample % rate == 0) {
+				synthesizer.sample(SPMetaMoreMeta, avatar, sample, t, send);
+				synthesizer.sample(SPMetaScaling, avatar, sample, t, send);
+			}
+			for (StreamingProtocol protocol : protocols)
+				synthesizer.sample(protocol, avatar, sample, t, send);
+		}
+
+		if (Clock::now() >= nextReport) {
+			std::cout << datagrams << " datagrams, " << bytes / 1024 << " KiB sent" << std::endl;
+			nextReport += std::chrono::seconds(1);
+		}
+	}
+
+	std::cout << "Sent " << datagrams << " datagrams, " << bytes << " bytes" << std::endl;
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+	closesocket(sock);
+	WSACleanup();
+#else
+	close(sock);
+#endif
+	return 0;
+}
@@ -0,0 +1,359 @@
+#include "mvnsynthesizer.h"
+#include "streamer.h"
+#include "mvnmath.h"
+
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+	const char HexDigits[] = "0123456789ABCDEF";
+
+	// The item count in the header is a single byte
+	const size_t MaxRecordsPerDatagram = 255;
+
+	// Fields per record after the 4 byte segment ID, see the datagram classes for the layouts
+	int recordFloats(StreamingProtocol protocol)
+	{
+		switch (protocol)
+		{
+		case SPPoseEuler: return 6;
+		case SPPoseQuaternion: return 7;
+		case SPPoseUnity3D: return 7;
+		case SPLinearSegmentKinematics: return 9;
+		case SPAngularSegmentKinematics: return 10;
+		case SPTrackerKinematics: return 16;
+		default: return 0;
+		}
+	}
+
+	// Deterministic pseudo random value in [-1, 1] for the noise pattern
+	double hashNoise(double x)
+	{
+		double value = std::sin(x * 12.9898) * 43758.5453;
+		return 2.0 * (value - std::floor(value)) - 1.0;
+	}
+
+	void multiply(const double a[4], const double b[4], double out[4])
+	{
+		out[0] = a[0] * b[0] - a[1] * b[1] - a[2] * b[2] - a[3] * b[3];
+		out[1] = a[0] * b[1] + a[1] * b[0] + a[2] * b[3] - a[3] * b[2];
+		out[2] = a[0] * b[2] - a[1] * b[3] + a[2] * b[0] + a[3] * b[1];
+		out[3] = a[0] * b[3] + a[1] * b[2] - a[2] * b[1] + a[3] * b[0];
+	}
+
+	void axisAngle(double x, double y, double z, double angle, double out[4])
+	{
+		double s = std::sin(angle / 2);
+		out[0] = std::cos(angle / 2);
+		out[1] = x * s;
+		out[2] = y * s;
+		out[3] = z * s;
+	}
+
+	// Angular velocity taking orientation a to b in dt seconds, from the small angle approximation
+	void angularVelocity(const float a[4], const float b[4], double dt, double out[3])
+	{
+		double inverse[4] = { a[0], -a[1], -a[2], -a[3] };
+		double next[4] = { b[0], b[1], b[2], b[3] };
+		double delta[4];
+		multiply(inverse, next, delta);
+		double sign = delta[0] < 0 ? -1.0 : 1.0;
+		for (int k = 0; k < 3; k++)
+			out[k] = sign * 2.0 * delta[k + 1] / dt;
+	}
+}
+
+MvnSynthesizer::MvnSynthesizer(const Config& config)
+	: m_config(config)
+{
+	m_packet.reserve(DatagramHeader::Size + MaxRecordsPerDatagram * 17 * sizeof(uint32_t));
+}
+
+/*! The pose of \a segment at \a timeSeconds, in the MVN Z-up frame */
+void MvnSynthesizer::pose(int segment, double timeSeconds, SegmentPose& out) const
+{
+	const double TwoPi = 2.0 * MvnMath::Pi;
+	int body = m_config.bodySegmentCount;
+	int props = m_config.propCount;
+
+	// Rest layout: the body as a column, props in front of it and the fingers out to either side
+	double position[3] = { 0.0, 0.0, 0.0 };
+	if (segment < body) {
+		position[2] = 0.05 * segment;
+	}
+	else if (segment < body + props) {
+		position[0] = 0.5;
+		position[2] = 1.0 + 0.1 * (segment - body);
+	}
+	else {
+		int finger = segment - body - props;
+		int half = m_config.fingerTrackingSegmentCount / 2;
+		position[1] = (finger < half ? 0.8 : -0.8) + 0.02 * (finger % (half ? half : 1));
+		position[2] = 1.4;
+	}
+
+	double orientation[4] = { 1.0, 0.0, 0.0, 0.0 };
+
+	switch (m_config.pattern)
+	{
+	case Static:
+		break;
+
+	case Sway:
+	{
+		double phase = TwoPi * 0.5 * timeSeconds + 0.2 * segment;
+		position[0] += 0.05 * std::sin(phase);
+		axisAngle(0, 0, 1, 0.3 * std::sin(phase), orientation);
+		break;
+	}
+
+	case Walk:
+	{
+		double heading = TwoPi * 0.2 * timeSeconds;
+		double x = position[0], y = position[1];
+		position[0] = std::cos(heading) + x * std::cos(heading + MvnMath::Pi / 2) - y * std::sin(heading + MvnMath::Pi / 2);
+		position[1] = std::sin(heading) + x * std::sin(heading + MvnMath::Pi / 2) + y * std::cos(heading + MvnMath::Pi / 2);
+
+		double yaw[4], swing[4];
+		axisAngle(0, 0, 1, heading + MvnMath::Pi / 2, yaw);
+		axisAngle(0, 1, 0, 0.5 * std::sin(TwoPi * timeSeconds + (segment % 2) * MvnMath::Pi), swing);
+		multiply(yaw, swing, orientation);
+		break;
+	}
+
+	case Noise:
+	{
+		double key = segment * 1000.0 + std::floor(timeSeconds * 1000.0);
+		for (int k = 0; k < 3; k++)
+			position[k] += 0.01 * hashNoise(key + k);
+		axisAngle(0, 0, 1, 0.05 * hashNoise(key + 3), orientation);
+		break;
+	}
+	}
+
+	for (int k = 0; k < 3; k++)
+		out.position[k] = (float)position[k];
+	for (int k = 0; k < 4; k++)
+		out.orientation[k] = (float)orientation[k];
+}
+
+void MvnSynthesizer::sample(StreamingProtocol protocol, int avatarId, int32_t sampleCounter, double timeSeconds, const Emit& emit)
+{
+	switch (protocol)
+	{
+	case SPMetaMoreMeta:
+		metaSample(avatarId, sampleCounter, timeSeconds, emit);
+		break;
+	case SPMetaScaling:
+		scalingSample(avatarId, sampleCounter, timeSeconds, emit);
+		break;
+	case SPTimeCode:
+		timeCodeSample(avatarId, sampleCounter, timeSeconds, emit);
+		break;
+	default:
+		if (recordFloats(protocol))
+			recordSample(protocol, avatarId, sampleCounter, timeSeconds, emit);
+		break;
+	}
+}
+
+void MvnSynthesizer::beginHeader(StreamingProtocol protocol, int avatarId, int32_t sampleCounter, double timeSeconds)
+{
+	m_packet.assign(DatagramHeader::Size, 0);
+	uint8_t* header = m_packet.data();
+
+	memcpy(header, "MXTP", 4);
+	header[4] = HexDigits[(protocol >> 4) & 0xF];
+	header[5] = HexDigits[protocol & 0xF];
+	WireOrder::store<int32_t>(header + 6, sampleCounter);
+	WireOrder::store<int32_t>(header + 12, (int32_t)(timeSeconds * 1000.0));
+	header[16] = (uint8_t)avatarId;
+	header[17] = (uint8_t)m_config.bodySegmentCount;
+	header[18] = (uint8_t)m_config.propCount;
+	header[19] = (uint8_t)m_config.fingerTrackingSegmentCount;
+}
+
+void MvnSynthesizer::finishDatagram(uint8_t datagramCounter, uint8_t dataCount, const Emit& emit)
+{
+	uint8_t* header = m_packet.data();
+	header[10] = datagramCounter;
+	header[11] = dataCount;
+	WireOrder::store<uint16_t>(header + 22, (uint16_t)(m_packet.size() - DatagramHeader::Size));
+	emit(m_packet.data(), m_packet.size());
+}
+
+void MvnSynthesizer::put(float value)
+{
+	size_t offset = m_packet.size();
+	m_packet.resize(offset + sizeof(value));
+	WireOrder::store<float>(m_packet.data() + offset, value);
+}
+
+void MvnSynthesizer::put(int32_t value)
+{
+	size_t offset = m_packet.size();
+	m_packet.resize(offset + sizeof(value));
+	WireOrder::store<int32_t>(m_packet.data() + offset, value);
+}
+
+void MvnSynthesizer::put(const std::string& value)
+{
+	put((int32_t)value.size());
+	m_packet.insert(m_packet.end(), value.begin(), value.end());
+}
+
+/*! Fixed size segment records, fragmented over as many datagrams as maxDatagramSize requires */
+void MvnSynthesizer::recordSample(StreamingProtocol protocol, int avatarId, int32_t sampleCounter, double timeSeconds, const Emit& emit)
+{
+	const double dt = 1e-3;
+	size_t recordSize = (1 + recordFloats(protocol)) * sizeof(uint32_t);
+	size_t perDatagram = m_config.maxDatagramSize > DatagramHeader::Size + recordSize
+		? (m_config.maxDatagramSize - DatagramHeader::Size) / recordSize : 1;
+	if (perDatagram > MaxRecordsPerDatagram)
+		perDatagram = MaxRecordsPerDatagram;
+
+	int segments = segmentCount();
+	size_t fragments = (segments + perDatagram - 1) / perDatagram;
+	int segment = 0;
+
+	for (size_t fragment = 0; fragment < fragments; fragment++)
+	{
+		beginHeader(protocol, avatarId, sampleCounter, timeSeconds);
+
+		uint8_t count = 0;
+		for (; segment < segments && count < perDatagram; segment++, count++)
+		{
+			SegmentPose now, before, earlier;
+			pose(segment, timeSeconds, now);
+			put((int32_t)(segment + 1));
+
+			switch (protocol)
+			{
+			case SPPoseEuler:
+			{
+				// Y-up positions in centimeters and Euler angles in degrees
+				double quat[4] = { now.orientation[0], now.orientation[1], now.orientation[2], now.orientation[3] };
+				double euler[3];
+				MvnMath::eulerFromQuaternion(quat, euler);
+				put(now.position[1] * 100.0f);
+				put(now.position[2] * 100.0f);
+				put(now.position[0] * 100.0f);
+				for (int k = 0; k < 3; k++)
+					put((float)euler[k]);
+				break;
+			}
+
+			case SPPoseQuaternion:
+				for (int k = 0; k < 3; k++)
+					put(now.position[k]);
+				for (int k = 0; k < 4; k++)
+					put(now.orientation[k]);
+				break;
+
+			case SPPoseUnity3D:
+				// Left-handed Y-up, x to the right and z forward
+				put(-now.position[1]);
+				put(now.position[2]);
+				put(now.position[0]);
+				put(now.orientation[0]);
+				put(now.orientation[2]);
+				put(-now.orientation[3]);
+				put(-now.orientation[1]);
+				break;
+
+			case SPLinearSegmentKinematics:
+				pose(segment, timeSeconds - dt, before);
+				pose(segment, timeSeconds - 2 * dt, earlier);
+				for (int k = 0; k < 3; k++)
+					put(now.position[k]);
+				for (int k = 0; k < 3; k++)
+					put((float)((now.position[k] - before.position[k]) / dt));
+				for (int k = 0; k < 3; k++)
+					put((float)((now.position[k] - 2.0 * before.position[k] + earlier.position[k]) / (dt * dt)));
+				break;
+
+			case SPAngularSegmentKinematics:
+			case SPTrackerKinematics:
+			{
+				pose(segment, timeSeconds - dt, before);
+				pose(segment, timeSeconds - 2 * dt, earlier);
+				double velocity[3], previousVelocity[3];
+				angularVelocity(before.orientation, now.orientation, dt, velocity);
+				angularVelocity(earlier.orientation, before.orientation, dt, previousVelocity);
+
+				for (int k = 0; k < 4; k++)
+					put(now.orientation[k]);
+
+				if (protocol == SPAngularSegmentKinematics) {
+					for (int k = 0; k < 3; k++)
+						put((float)velocity[k]);
+					for (int k = 0; k < 3; k++)
+						put((float)((velocity[k] - previousVelocity[k]) / dt));
+				}
+				else {
+					// free acceleration, acceleration with gravity, gyroscope and a fixed magnetic field
+					for (int k = 0; k < 3; k++)
+						put((float)((now.position[k] - 2.0 * before.position[k] + earlier.position[k]) / (dt * dt)));
+					for (int k = 0; k < 3; k++)
+						put((float)((now.position[k] - 2.0 * before.position[k] + earlier.position[k]) / (dt * dt) + (k == 2 ? 9.81 : 0.0)));
+					for (int k = 0; k < 3; k++)
+						put((float)velocity[k]);
+					put(0.4f);
+					put(0.0f);
+					put(-0.9f);
+				}
+				break;
+			}
+
+			default:
+				break;
+			}
+		}
+
+		uint8_t counter = (uint8_t)(fragment == fragments - 1 ? 0x80 | fragment : fragment);
+		finishDatagram(counter, count, emit);
+	}
+}
+
+void MvnSynthesizer::metaSample(int avatarId, int32_t sampleCounter, double timeSeconds, const Emit& emit)
+{
+	static const char* Colors[] = { "FF8000", "0080FF", "40C040", "C040C0" };
+
+	char xmid[16];
+	snprintf(xmid, sizeof(xmid), "%08X", 0x00A00000 + avatarId);
+
+	beginHeader(SPMetaMoreMeta, avatarId, sampleCounter, timeSeconds);
+	put(std::string("name:Synthetic ") + std::to_string(avatarId) + "\ncolor:" + Colors[avatarId % 4] + "\nxmid:" + xmid + "\n");
+	finishDatagram(0x80, 1, emit);
+}
+
+/*! The null pose definition, one datagram with every segment name and its rest position */
+void MvnSynthesizer::scalingSample(int avatarId, int32_t sampleCounter, double timeSeconds, const Emit& emit)
+{
+	beginHeader(SPMetaScaling, avatarId, sampleCounter, timeSeconds);
+
+	int segments = segmentCount();
+	put((int32_t)segments);
+	for (int segment = 0; segment < segments; segment++)
+	{
+		SegmentPose rest;
+		pose(segment, 0.0, rest);
+		put("Segment" + std::to_string(segment + 1));
+		for (int k = 0; k < 3; k++)
+			put(rest.position[k]);
+	}
+	finishDatagram(0x80, (uint8_t)(segments > 0xFF ? 0xFF : segments), emit);
+}
+
+void MvnSynthesizer::timeCodeSample(int avatarId, int32_t sampleCounter, double timeSeconds, const Emit& emit)
+{
+	long long ms = (long long)(timeSeconds * 1000.0);
+	char timeCode[32];
+	snprintf(timeCode, sizeof(timeCode), "%02d:%02d:%02d.%03d",
+		(int)((ms / 3600000) % 100), (int)((ms / 60000) % 60), (int)((ms / 1000) % 60), (int)(ms % 1000));
+
+	beginHeader(SPTimeCode, avatarId, sampleCounter, timeSeconds);
+	put(std::string(timeCode));
+	finishDatagram(0x80, 1, emit);
+}
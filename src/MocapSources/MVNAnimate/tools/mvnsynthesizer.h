@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "datagram.h"
+
+/*! \class MvnSynthesizer
+	\brief Builds spec conformant MVN datagrams for made-up avatars
+
+	Used by the stream generator and the parser benchmark, so neither needs a suit or an MVN licence.
+	Segment IDs follow the MVN order: body segments first, then props, then finger segments.
+	Pose protocols are split into several datagrams when a sample does not fit in
+	maxDatagramSize, with the datagram counter set as MVN does.
+*/
+class MvnSynthesizer
+{
+public:
+	enum MotionPattern
+	{
+		Static,		// T-pose that never moves
+		Sway,		// every segment rocks in place
+		Walk,		// pelvis walks a 1 m circle while the limbs swing
+		Noise		// seeded random jitter, reproducible between runs
+	};
+
+	struct Config
+	{
+		int avatarCount = 1;
+		int bodySegmentCount = 23;
+		int propCount = 0;
+		int fingerTrackingSegmentCount = 0;
+		MotionPattern pattern = Walk;
+
+		// Largest datagram to emit, pose samples bigger than this are fragmented
+		size_t maxDatagramSize = 1500;
+	};
+
+	typedef std::function<void(const uint8_t* data, size_t size)> Emit;
+
+	explicit MvnSynthesizer(const Config& config);
+
+	inline const Config& config() const { return m_config; }
+	inline int segmentCount() const { return m_config.bodySegmentCount + m_config.propCount + m_config.fingerTrackingSegmentCount; }
+
+	/*! Emit the datagrams of \a protocol for one sample of \a avatarId at \a timeSeconds.
+		Supported are the quaternion, Unity3D, Euler, linear and angular segment kinematics, tracker
+		kinematics, meta data, scaling and time code protocols.
+	*/
+	void sample(StreamingProtocol protocol, int avatarId, int32_t sampleCounter, double timeSeconds, const Emit& emit);
+
+private:
+	struct SegmentPose
+	{
+		float position[3];
+		float orientation[4];	// w, x, y, z
+	};
+
+	void pose(int segment, double timeSeconds, SegmentPose& out) const;
+
+	void beginHeader(StreamingProtocol protocol, int avatarId, int32_t sampleCounter, double timeSeconds);
+	void finishDatagram(uint8_t datagramCounter, uint8_t dataCount, const Emit& emit);
+
+	void recordSample(StreamingProtocol protocol, int avatarId, int32_t sampleCounter, double timeSeconds, const Emit& emit);
+	void metaSample(int avatarId, int32_t sampleCounter, double timeSeconds, const Emit& emit);
+	void scalingSample(int avatarId, int32_t sampleCounter, double timeSeconds, const Emit& emit);
+	void timeCodeSample(int avatarId, int32_t sampleCounter, double timeSeconds, const Emit& emit);
+
+	void put(float value);
+	void put(int32_t value);
+	void put(const std::string& value);
+
+	Config m_config;
+	std::vector<uint8_t> m_packet;
+};
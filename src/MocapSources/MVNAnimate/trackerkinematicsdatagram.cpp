@@ -67,6 +67,34 @@ TrackerKinematicsDatagram::~TrackerKinematicsDatagram()
 {
 }
 
+/*! Gather the record at \a index from the decoded columns */
+TrackerKinematicsDatagram::Kinematics TrackerKinematicsDatagram::record(size_t index) const
+{
+	Kinematics kin;
+	kin.segmentId = m_records.segmentId[index];
+	for (int k = 0; k < 4; k++)
+		kin.sens_rot[k] = m_records.column(1 + k)[index];
+	for (int k = 0; k < 3; k++)
+		kin.sen_freeAcc[k] = m_records.column(5 + k)[index];
+	for (int k = 0; k < 3; k++)
+		kin.sen_acc[k] = m_records.column(8 + k)[index];
+	for (int k = 0; k < 3; k++)
+		kin.sen_gyr[k] = m_records.column(11 + k)[index];
+	for (int k = 0; k < 3; k++)
+		kin.sen_mag[k] = m_records.column(14 + k)[index];
+	return kin;
+}
+
+/*! The record of \a segmentIdx, with a segmentId of -1 if the packet did not contain it */
+TrackerKinematicsDatagram::Kinematics TrackerKinematicsDatagram::GetSegmentData(Segment segmentIdx) const
+{
+	// ID is index + 1 accoring to https://www.xsens.com/hubfs/Downloads/Manuals/MVN_real-time_network_streaming_protocol_specification.pdf
+	int index = m_records.find(segmentIdx + 1);
+	if (index < 0)
+		return Kinematics{-1};
+	return record(index);
+}
+
 /*! Deserialize the data from \a arr
 	\sa serializeData
 */
@@ -74,73 +102,53 @@ void TrackerKinematicsDatagram::deserializeData(Streamer &inputStreamer)
 {
 	Streamer* streamer = &inputStreamer;
 
-	for (int i = 0; i < dataCount(); i++)
-	{
-		Kinematics kin;
-
-		// 4 byte
-		streamer->read(kin.segmentId);
-
-		// Store the Sensor rotation in a Vector -> 16 byte	(4 x 4 byte)
-		for (int k = 0; k < 4; k++)
-			streamer->read(kin.sens_rot[k]);
-
-		// Store the Sensor free acceleration in a Vector -> 12 byte	(3 x 4 byte)
-		for (int k = 0; k < 3; k++)
-			streamer->read(kin.sen_freeAcc[k]);
-
-		// Store the  Sensor Acceleration in a Vector -> 12 byte	(3 x 4 byte)
-		for (int k = 0; k < 3; k++)
-			streamer->read(kin.sen_acc[k]);
-
-		// Store the Sensor gyroscope in a Vector -> 12 byte	(3 x 4 byte)
-		for (int k = 0; k < 3; k++)
-			streamer->read(kin.sen_gyr[k]);
-
-		// Store the Sensor magnetometer a Vector -> 12 byte	(3 x 4 byte)
-		for (int k = 0; k < 3; k++)
-			streamer->read(kin.sen_mag[k]);
-
-		m_data.push_back(kin);
+	// Every item is a fixed 68 byte record, so the array is decoded in one go (or just the filtered segments)
+	const uint8_t* records = nullptr;
+	if (!streamer->readBlock(records, dataCount() * m_records.RecordSize)) {
+		m_records.clear();
+		return;
 	}
+	RecordDecoder::decode(records, dataCount(), segmentFilter(), m_records);
 }
 
 /*! Print Data datagram in a formatted way
 */
 void TrackerKinematicsDatagram::printData() const
 {
-	for (int i = 0; i < m_data.size(); i++)
+	for (size_t i = 0; i < m_records.count; i++)
 	{
-		std::cout << "Segment ID: " << m_data.at(i).segmentId << std::endl;
+		const Kinematics kin = record(i);
+
+		std::cout << "Segment ID: " << kin.segmentId << std::endl;
 		// Sensor rotation quaternion
 		std::cout << "Sensor Rotation: " << "(";
-		std::cout << "re: " << m_data.at(i).sens_rot[0] << ", ";
-		std::cout << "i: " << m_data.at(i).sens_rot[1] << ", ";
-		std::cout << "j: " << m_data.at(i).sens_rot[1] << ", ";
-		std::cout << "k: " << m_data.at(i).sens_rot[2] << ")"<< std::endl;
+		std::cout << "re: " << kin.sens_rot[0] << ", ";
+		std::cout << "i: " << kin.sens_rot[1] << ", ";
+		std::cout << "j: " << kin.sens_rot[1] << ", ";
+		std::cout << "k: " << kin.sens_rot[2] << ")"<< std::endl;
 
 		// Sensor free acceleration
 		std::cout << "Sensor free acceleration: " << "(";
-		std::cout << "x: " << m_data.at(i).sen_freeAcc[0] << ", ";
-		std::cout << "y: " << m_data.at(i).sen_freeAcc[1] << ", ";
-		std::cout << "z: " << m_data.at(i).sen_freeAcc[2] << ")"<< std::endl;
+		std::cout << "x: " << kin.sen_freeAcc[0] << ", ";
+		std::cout << "y: " << kin.sen_freeAcc[1] << ", ";
+		std::cout << "z: " << kin.sen_freeAcc[2] << ")"<< std::endl;
 
 		// Sensor Acceleration
 		std::cout << "Sensor Acceleration: " << "(";
-		std::cout << "x: " << m_data.at(i).sen_acc[0] << ", ";
-		std::cout << "y: " << m_data.at(i).sen_acc[1] << ", ";
-		std::cout << "z: " << m_data.at(i).sen_acc[2] << ")"<< std::endl;
+		std::cout << "x: " << kin.sen_acc[0] << ", ";
+		std::cout << "y: " << kin.sen_acc[1] << ", ";
+		std::cout << "z: " << kin.sen_acc[2] << ")"<< std::endl;
 
 		// Sensor gyroscope
 		std::cout << "Sensor gyroscope: " << "(";
-		std::cout << "x: " << m_data.at(i).sen_gyr[0] << ", ";
-		std::cout << "y: " << m_data.at(i).sen_gyr[1] << ", ";
-		std::cout << "z: " << m_data.at(i).sen_gyr[2] << ")"<< std::endl;
+		std::cout << "x: " << kin.sen_gyr[0] << ", ";
+		std::cout << "y: " << kin.sen_gyr[1] << ", ";
+		std::cout << "z: " << kin.sen_gyr[2] << ")"<< std::endl;
 
 		// Sensor magnetometer
 		std::cout << "Sensor magnetometer: " << "(";
-		std::cout << "x: " << m_data.at(i).sen_mag[0] << ", ";
-		std::cout << "y: " << m_data.at(i).sen_mag[1] << ", ";
-		std::cout << "z: " << m_data.at(i).sen_mag[2] << ")"<< std::endl << std::endl;
+		std::cout << "x: " << kin.sen_mag[0] << ", ";
+		std::cout << "y: " << kin.sen_mag[1] << ", ";
+		std::cout << "z: " << kin.sen_mag[2] << ")"<< std::endl << std::endl;
 	}
 }
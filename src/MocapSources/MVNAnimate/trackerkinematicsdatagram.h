@@ -28,17 +28,14 @@
 #define TRACKERSKINEMATICSDATAGRAM_H
 
 #include "datagram.h"
+#include "recorddecoder.h"
+#include <segments.h>
 
 class TrackerKinematicsDatagram : public Datagram {
 public:
 	TrackerKinematicsDatagram();
 	virtual ~TrackerKinematicsDatagram();
 	virtual void printData() const override;
-
-protected:
-	virtual void deserializeData(Streamer &inputStreamer) override;
-
-private:
 	struct Kinematics {
 		int segmentId;
 		float sens_rot[4];
@@ -47,8 +44,15 @@ private:
 		float sen_gyr[3];
 		float sen_mag[3];
 	};
+	Kinematics GetSegmentData(Segment segmentIdx) const;
+
+protected:
+	virtual void deserializeData(Streamer &inputStreamer) override;
+
+private:
+	Kinematics record(size_t index) const;
 
-	std::vector<Kinematics> m_data;
+	RecordColumns<17, MaxDataCount> m_records;
 };
 
 #endif
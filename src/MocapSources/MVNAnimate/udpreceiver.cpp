@@ -0,0 +1,425 @@
+#include "udpreceiver.h"
+
+#include <cstring>
+#include <chrono>
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#elif defined(__linux) || defined(__linux__) || defined(linux)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <ctime>
+#include <cerrno>
+#endif
+
+bool UdpReceiver::isMulticast(const std::string& address)
+{
+	in_addr parsed;
+	return inet_pton(AF_INET, address.c_str(), &parsed) == 1 && (ntohl(parsed.s_addr) >> 28) == 0xE;
+}
+
+// Large enough to absorb a few frames of every protocol at 240 Hz while the thread is descheduled
+static const int ReceiveBufferSize = 1 << 20;
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+
+// select() cannot be woken by another thread, so long waits are sliced to observe wake() requests
+static const int WakeIntervalMs = 100;
+
+UdpReceiver::UdpReceiver()
+	: m_bound(false)
+	, m_kernelTimestamps(false)
+	, m_drained(true)
+	, m_truncated(0)
+	, m_spinUs(0)
+	, m_socket(INVALID_SOCKET)
+{
+	WSADATA wsaData;
+	WSAStartup(MAKEWORD(2, 2), &wsaData);
+}
+
+UdpReceiver::~UdpReceiver()
+{
+	close();
+	WSACleanup();
+}
+
+bool UdpReceiver::bind(const std::string& address, uint16_t port)
+{
+	return open(address, port, false);
+}
+
+bool UdpReceiver::open(const std::string& address, uint16_t port, bool shared)
+{
+	close();
+
+	addrinfo hints = {};
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+	hints.ai_protocol = IPPROTO_UDP;
+	hints.ai_flags = AI_PASSIVE;
+
+	addrinfo* result = nullptr;
+	std::string service = std::to_string(port);
+	if (getaddrinfo(address.empty() ? nullptr : address.c_str(), service.c_str(), &hints, &result) != 0)
+		return false;
+
+	SOCKET sock = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+	if (sock == INVALID_SOCKET) {
+		freeaddrinfo(result);
+		return false;
+	}
+
+	setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (const char*)&ReceiveBufferSize, sizeof(ReceiveBufferSize));
+
+	BOOL reuse = TRUE;
+	if (shared)
+		setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+	if (::bind(sock, result->ai_addr, (int)result->ai_addrlen) == SOCKET_ERROR) {
+		freeaddrinfo(result);
+		closesocket(sock);
+		return false;
+	}
+	freeaddrinfo(result);
+
+	// Non-blocking so a batch can be drained until the socket reports it would block
+	u_long nonBlocking = 1;
+	ioctlsocket(sock, FIONBIO, &nonBlocking);
+
+	m_socket = (uintptr_t)sock;
+	m_bound = true;
+	return true;
+}
+
+bool UdpReceiver::bindMulticast(const std::string& group, uint16_t port, const std::string& interfaceAddress)
+{
+	ip_mreq membership = {};
+	if (!isMulticast(group) || inet_pton(AF_INET, group.c_str(), &membership.imr_multiaddr) != 1)
+		return false;
+	membership.imr_interface.s_addr = htonl(INADDR_ANY);
+	if (!interfaceAddress.empty() && inet_pton(AF_INET, interfaceAddress.c_str(), &membership.imr_interface) != 1)
+		return false;
+
+	// Windows cannot bind to a group address, the membership alone selects the group
+	if (!open("", port, true))
+		return false;
+	if (setsockopt((SOCKET)m_socket, IPPROTO_IP, IP_ADD_MEMBERSHIP, (const char*)&membership, sizeof(membership)) == SOCKET_ERROR) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+void UdpReceiver::close()
+{
+	if (m_socket != INVALID_SOCKET)
+		closesocket((SOCKET)m_socket);
+	m_socket = INVALID_SOCKET;
+	m_bound = false;
+}
+
+size_t UdpReceiver::receive(DatagramBatch& batch, int timeoutMs)
+{
+	batch.clear();
+	m_drained = true;
+	if (!m_bound)
+		return 0;
+
+	uint32_t spinUs = timeoutMs != 0 ? m_spinUs.load() : 0;
+	if (spinUs) {
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(spinUs);
+		do {
+			if (size_t count = drain(batch))
+				return count;
+		} while (std::chrono::steady_clock::now() < deadline);
+	}
+
+	int waitMs = (timeoutMs < 0 || timeoutMs > WakeIntervalMs) ? WakeIntervalMs : timeoutMs;
+	timeval timeout;
+	timeout.tv_sec = waitMs / 1000;
+	timeout.tv_usec = (waitMs % 1000) * 1000;
+
+	fd_set readSet;
+	FD_ZERO(&readSet);
+	FD_SET((SOCKET)m_socket, &readSet);
+	if (select(0, &readSet, nullptr, nullptr, &timeout) <= 0)
+		return 0;
+
+	return drain(batch);
+}
+
+size_t UdpReceiver::drain(DatagramBatch& batch)
+{
+	// No per-packet kernel stamp for UDP here, everything pending is taken to have arrived now
+	uint64_t receiveTimeNs = DatagramBatch::nowNs();
+
+	size_t count = 0;
+	m_drained = false;
+	while (count < DatagramBatch::MaxDatagrams)
+	{
+		int received = recv((SOCKET)m_socket, (char*)batch.slot(count), (int)DatagramBatch::MaxDatagramSize, 0);
+		if (received == SOCKET_ERROR) {
+			if (WSAGetLastError() == WSAEMSGSIZE) {
+				m_truncated++;
+				continue;
+			}
+			// WSAEWOULDBLOCK: everything pending has been drained
+			m_drained = true;
+			break;
+		}
+		batch.setReceiveTime(count, receiveTimeNs);
+		batch.setSize(count++, (size_t)received);
+	}
+	batch.setCount(count);
+	return count;
+}
+
+void UdpReceiver::wake()
+{
+}
+
+bool UdpReceiver::setBusyPoll(uint32_t microseconds)
+{
+	return microseconds == 0;
+}
+
+#elif defined(__linux) || defined(__linux__) || defined(linux)
+
+// Room for the SCM_TIMESTAMPNS control message of one datagram
+static const size_t ControlSize = CMSG_SPACE(sizeof(timespec));
+
+UdpReceiver::UdpReceiver()
+	: m_bound(false)
+	, m_kernelTimestamps(false)
+	, m_drained(true)
+	, m_truncated(0)
+	, m_spinUs(0)
+	, m_socket(-1)
+	, m_epoll(-1)
+	, m_wakeFd(-1)
+	, m_messages(DatagramBatch::MaxDatagrams)
+	, m_iovecs(DatagramBatch::MaxDatagrams)
+	, m_control(DatagramBatch::MaxDatagrams * ControlSize)
+	, m_boundBatch(nullptr)
+{
+}
+
+UdpReceiver::~UdpReceiver()
+{
+	close();
+}
+
+bool UdpReceiver::bind(const std::string& address, uint16_t port)
+{
+	return open(address, port, false);
+}
+
+bool UdpReceiver::open(const std::string& address, uint16_t port, bool shared)
+{
+	close();
+
+	addrinfo hints = {};
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+	hints.ai_protocol = IPPROTO_UDP;
+	hints.ai_flags = AI_PASSIVE;
+
+	addrinfo* result = nullptr;
+	std::string service = std::to_string(port);
+	if (getaddrinfo(address.empty() ? nullptr : address.c_str(), service.c_str(), &hints, &result) != 0)
+		return false;
+
+	m_socket = socket(result->ai_family, result->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, result->ai_protocol);
+	if (m_socket < 0) {
+		freeaddrinfo(result);
+		return false;
+	}
+
+	setsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, &ReceiveBufferSize, sizeof(ReceiveBufferSize));
+
+	int enable = 1;
+	m_kernelTimestamps = setsockopt(m_socket, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) == 0;
+	if (shared)
+		setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+	int bound = ::bind(m_socket, result->ai_addr, result->ai_addrlen);
+	freeaddrinfo(result);
+	if (bound < 0) {
+		close();
+		return false;
+	}
+
+	m_epoll = epoll_create1(EPOLL_CLOEXEC);
+	m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (m_epoll < 0 || m_wakeFd < 0) {
+		close();
+		return false;
+	}
+
+	epoll_event event = {};
+	event.events = EPOLLIN;
+	event.data.fd = m_socket;
+	epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_socket, &event);
+	event.data.fd = m_wakeFd;
+	epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeFd, &event);
+
+	m_bound = true;
+	return true;
+}
+
+bool UdpReceiver::bindMulticast(const std::string& group, uint16_t port, const std::string& interfaceAddress)
+{
+	ip_mreq membership = {};
+	if (!isMulticast(group) || inet_pton(AF_INET, group.c_str(), &membership.imr_multiaddr) != 1)
+		return false;
+	membership.imr_interface.s_addr = htonl(INADDR_ANY);
+	if (!interfaceAddress.empty() && inet_pton(AF_INET, interfaceAddress.c_str(), &membership.imr_interface) != 1)
+		return false;
+
+	// Bound to the group rather than the wildcard, so the socket only sees traffic for that group
+	if (!open(group, port, true))
+		return false;
+	if (setsockopt(m_socket, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) < 0) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+void UdpReceiver::close()
+{
+	if (m_epoll >= 0)
+		::close(m_epoll);
+	if (m_wakeFd >= 0)
+		::close(m_wakeFd);
+	if (m_socket >= 0)
+		::close(m_socket);
+	m_epoll = m_wakeFd = m_socket = -1;
+	m_bound = false;
+	m_kernelTimestamps = false;
+}
+
+/*! Point the recvmmsg vectors at the slots of \a batch, so received payloads land in place */
+void UdpReceiver::bindBatch(DatagramBatch& batch)
+{
+	for (size_t i = 0; i < DatagramBatch::MaxDatagrams; i++)
+	{
+		m_iovecs[i].iov_base = batch.slot(i);
+		m_iovecs[i].iov_len = DatagramBatch::MaxDatagramSize;
+
+		m_messages[i] = {};
+		m_messages[i].msg_hdr.msg_iov = &m_iovecs[i];
+		m_messages[i].msg_hdr.msg_iovlen = 1;
+		m_messages[i].msg_hdr.msg_control = m_control.data() + i * ControlSize;
+	}
+	m_boundBatch = &batch;
+}
+
+size_t UdpReceiver::receive(DatagramBatch& batch, int timeoutMs)
+{
+	batch.clear();
+	m_drained = true;
+	if (!m_bound)
+		return 0;
+
+	if (m_boundBatch != &batch)
+		bindBatch(batch);
+
+	// Spinning skips the sleep and wake-up in epoll_wait while packets keep coming
+	uint32_t spinUs = timeoutMs != 0 ? m_spinUs.load() : 0;
+	if (spinUs) {
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(spinUs);
+		do {
+			if (size_t count = drain(batch))
+				return count;
+		} while (std::chrono::steady_clock::now() < deadline);
+	}
+
+	epoll_event events[2];
+	int ready = epoll_wait(m_epoll, events, 2, timeoutMs);
+
+	bool readable = false;
+	for (int i = 0; i < ready; i++)
+	{
+		if (events[i].data.fd == m_wakeFd) {
+			uint64_t value;
+			ssize_t consumed = ::read(m_wakeFd, &value, sizeof(value));
+			(void)consumed;
+		}
+		else {
+			readable = true;
+		}
+	}
+	if (!readable)
+		return 0;
+
+	return drain(batch);
+}
+
+size_t UdpReceiver::drain(DatagramBatch& batch)
+{
+	// The kernel shrinks msg_controllen to what it wrote, so every slot is reset before each call
+	for (mmsghdr& message : m_messages)
+		message.msg_hdr.msg_controllen = ControlSize;
+
+	// One syscall drains up to MaxDatagrams pending payloads. Anything left over keeps the socket
+	// readable, so the next call returns immediately with the remainder.
+	int received = recvmmsg(m_socket, m_messages.data(), (unsigned int)m_messages.size(), MSG_DONTWAIT, nullptr);
+	m_drained = received < (int)m_messages.size();
+	if (received <= 0)
+		return 0;
+
+	uint64_t fallbackTimeNs = DatagramBatch::nowNs();
+
+	size_t count = 0;
+	for (int i = 0; i < received; i++)
+	{
+		if (m_messages[i].msg_hdr.msg_flags & MSG_TRUNC) {
+			m_truncated++;
+			continue;
+		}
+
+		uint64_t receiveTimeNs = fallbackTimeNs;
+		for (cmsghdr* cmsg = CMSG_FIRSTHDR(&m_messages[i].msg_hdr); cmsg; cmsg = CMSG_NXTHDR(&m_messages[i].msg_hdr, cmsg))
+		{
+			if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+				timespec stamp;
+				memcpy(&stamp, CMSG_DATA(cmsg), sizeof(stamp));
+				receiveTimeNs = (uint64_t)stamp.tv_sec * 1000000000ull + (uint64_t)stamp.tv_nsec;
+			}
+		}
+		batch.setReceiveTime(count, receiveTimeNs);
+
+		// Keep the batch dense if a truncated payload was skipped
+		if (count != (size_t)i)
+			memmove(batch.slot(count), batch.slot(i), m_messages[i].msg_len);
+		batch.setSize(count++, m_messages[i].msg_len);
+	}
+	batch.setCount(count);
+	return count;
+}
+
+bool UdpReceiver::setBusyPoll(uint32_t microseconds)
+{
+	// Raising it above net.core.busy_read needs CAP_NET_ADMIN
+	int value = (int)microseconds;
+	return m_socket >= 0 && setsockopt(m_socket, SOL_SOCKET, SO_BUSY_POLL, &value, sizeof(value)) == 0;
+}
+
+void UdpReceiver::wake()
+{
+	if (m_wakeFd < 0)
+		return;
+	uint64_t value = 1;
+	ssize_t written = ::write(m_wakeFd, &value, sizeof(value));
+	(void)written;
+}
+
+#endif
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+#include "datagrambatch.h"
+
+#if defined(__linux) || defined(__linux__) || defined(linux)
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
+/*! \class UdpReceiver
+	\brief Blocking, batched UDP receive engine for the MVN stream
+
+	receive() sleeps in the kernel until datagrams are pending and then drains as many as fit in
+	the batch in one go. On Linux this is epoll + recvmmsg, with an eventfd so wake() can unblock a
+	waiting receive immediately. Other platforms wait in select() and drain with non-blocking recv.
+
+	For the lowest latency on a machine with a core to spare, receive() can first spin on
+	non-blocking reads for a while before it goes to sleep, and on Linux the socket can busy poll
+	the network driver (SO_BUSY_POLL). Both burn CPU while the stream is idle.
+
+	Every datagram is stamped with its arrival time. On Linux that is the kernel's SO_TIMESTAMPNS
+	stamp, taken when the packet reached the socket, so time spent queued behind a sleeping or
+	descheduled receive thread counts towards the end-to-end latency. Elsewhere, or if the kernel
+	leaves the stamp out, the time the receive call returned is used instead.
+*/
+class UdpReceiver
+{
+public:
+	UdpReceiver();
+	~UdpReceiver();
+
+	UdpReceiver(UdpReceiver const&) = delete;
+	UdpReceiver& operator=(UdpReceiver const&) = delete;
+
+	bool bind(const std::string& address, uint16_t port);
+
+	/*! Join the IPv4 multicast \a group on \a port, through the interface with address
+		\a interfaceAddress or the one the routing table picks when it is empty. The port is shared
+		(SO_REUSEADDR), so several processes on one machine can subscribe to the same stream.
+	*/
+	bool bindMulticast(const std::string& group, uint16_t port, const std::string& interfaceAddress = "");
+
+	// True for an IPv4 address in 224.0.0.0/4
+	static bool isMulticast(const std::string& address);
+	void close();
+
+	// Waits up to timeoutMs (-1 = forever) and fills batch with every datagram that is pending
+	size_t receive(DatagramBatch& batch, int timeoutMs);
+
+	// Unblocks a receive() that is waiting on another thread
+	void wake();
+
+	// Poll without sleeping for up to this long before every blocking wait, 0 to always block
+	inline void setSpin(uint32_t microseconds) { m_spinUs = microseconds; }
+
+	// SO_BUSY_POLL for the bound socket, 0 turns it off. False where unsupported or not permitted.
+	bool setBusyPoll(uint32_t microseconds);
+
+	inline bool isBound() const { return m_bound; }
+
+	/*! False when the last receive() filled every slot the socket was read with, so more datagrams
+		may be pending. Counts what was read, not what was kept: truncated datagrams are dropped
+		from the batch, and a batch can come back short or empty while the socket is still full.
+	*/
+	inline bool isDrained() const { return m_drained; }
+	inline uint64_t truncatedCount() const { return m_truncated; }
+	inline bool hasKernelTimestamps() const { return m_kernelTimestamps; }
+
+private:
+	bool m_bound;
+	bool m_kernelTimestamps;
+	bool m_drained;
+	std::atomic<uint64_t> m_truncated;
+	std::atomic<uint32_t> m_spinUs;
+
+	bool open(const std::string& address, uint16_t port, bool shared);
+
+	// Read everything pending without waiting
+	size_t drain(DatagramBatch& batch);
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+	uintptr_t m_socket;
+#elif defined(__linux) || defined(__linux__) || defined(linux)
+	int m_socket;
+	int m_epoll;
+	int m_wakeFd;
+	std::vector<mmsghdr> m_messages;
+	std::vector<iovec> m_iovecs;
+	std::vector<uint8_t> m_control;
+	DatagramBatch* m_boundBatch;
+
+	void bindBatch(DatagramBatch& batch);
+#endif
+};
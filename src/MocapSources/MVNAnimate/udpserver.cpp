@@ -26,27 +26,32 @@
 
 #include "udpserver.h"
 
-DWORD WINAPI udpThreadFunc(LPVOID param)
-{
-	UdpServer* server = (UdpServer*) param;
-	server->readMessages();
-	return 0;
-}
-
-UdpServer::UdpServer(XsString address, uint16_t port, DatagramCallback data_recevied_cb)
+UdpServer::UdpServer(std::string address, uint16_t port, DatagramCallback data_recevied_cb, std::string capturePath, const DatagramFilter& filter, std::string multicastInterface)
 	: m_started(false)
 	, m_stopping(false)
+	, m_drainToLatest(false)
 {
 	m_port = port;
 	m_hostName = address;
 
-	m_parserManager.reset(new ParserManager(data_recevied_cb));
-	m_socket.reset(new XsSocket(IpProtocol::IP_UDP, NetworkLayerProtocol::NLP_IPV4));
+	m_parserManager.reset(new ParserManager(data_recevied_cb, filter));
+	m_receiver.reset(new UdpReceiver());
 
-	XsResultValue res = m_socket->bind(m_hostName,m_port);
+	if (!capturePath.empty() && !m_capture.open(capturePath))
+		std::cout << "Failed to open capture file " << capturePath << std::endl;
 
-	if (res == XRV_OK)
+	bool multicast = UdpReceiver::isMulticast(m_hostName);
+	bool bound = multicast
+		? m_receiver->bindMulticast(m_hostName, m_port, multicastInterface)
+		: m_receiver->bind(m_hostName, m_port);
+
+	if (bound) {
+		if (multicast)
+			std::cout << "Joined multicast group " << m_hostName << (multicastInterface.empty() ? "" : " on " + multicastInterface) << std::endl;
+		if (!m_receiver->hasKernelTimestamps())
+			std::cout << "No kernel receive timestamps, latency is measured from when packets are read" << std::endl;
 		startThread();
+	}
 	else
 		std::cout << "Failed to bind..." << std::endl;
 }
@@ -58,21 +63,39 @@ UdpServer::~UdpServer()
 
 void UdpServer::readMessages()
 {
-	XsByteArray buffer;
-
 	std::cout << "Waiting to receive packets from the client on port " << m_port << " ..." << std::endl << std::endl;
 
 	while (!m_stopping)
 	{
-		//std::cout << ".";
-		int rv = m_socket->read(buffer);
-		if (buffer.size() > 0)
-			m_parserManager->readDatagram(buffer);
-
-		buffer.clear();
-		XsTime::msleep(1);
+		// Sleeps in the kernel until datagrams arrive (or stopThread wakes us), then drains all of them
+		size_t received = m_receiver->receive(m_batch, -1);
+		if (received == 0)
+			continue;
+
+		if (!m_drainToLatest)
+		{
+			if (m_capture.isOpen())
+				m_capture.write(m_batch);
+			m_parserManager->readBatch(m_batch);
+			continue;
+		}
+
+		// Read on without waiting until the socket is empty, then parse only the newest samples.
+		// A batch short of truncated datagrams does not mean the socket is empty, the receiver knows.
+		for (;;)
+		{
+			if (m_capture.isOpen())
+				m_capture.write(m_batch);
+			m_parserManager->collectLatest(m_batch);
+			if (m_receiver->isDrained())
+				break;
+			m_receiver->receive(m_batch, 0);
+		}
+		m_parserManager->flushLatest();
 	}
 
+	if (m_parserManager->staleCount())
+		std::cout << "Skipped " << m_parserManager->staleCount() << " stale datagrams" << std::endl;
 	std::cout << "Stopping receiving packets..." << std::endl << std::endl;
 
 	m_stopping = false;
@@ -86,7 +109,7 @@ void UdpServer::startThread()
 
 	m_started = true;
 	m_stopping = false;
-	xsStartThread(udpThreadFunc, this, 0);
+	m_thread = std::thread(&UdpServer::readMessages, this);
 }
 
 void UdpServer::stopThread()
@@ -94,6 +117,14 @@ void UdpServer::stopThread()
 	if (!m_started)
 		return;
 	m_stopping = true;
-	while (m_started)
-		XsTime::msleep(10);
+	m_receiver->wake();
+	if (m_thread.joinable())
+		m_thread.join();
+}
+
+std::string UdpServer::setThreadScheduling(const ThreadScheduling& scheduling)
+{
+	if (!m_started || !m_thread.joinable())
+		return "receive thread is not running";
+	return scheduling.apply(m_thread);
 }
@@ -29,28 +29,51 @@
 
 #include "streamer.h"
 #include "parsermanager.h"
-#include <xstypes/xssocket.h>
-#include <xstypes/xsthread.h>
+#include "udpreceiver.h"
+#include "packetcapture.h"
+#include "threadscheduling.h"
 #include <atomic>
+#include <string>
+#include <thread>
 
 class UdpServer
 {
 public:
-	UdpServer(XsString address = "localhost", uint16_t port = 9763, DatagramCallback data_recevied_cb = nullptr);
+	/*! A multicast group as \a address joins that group, on the interface with address
+		\a multicastInterface if given, and shares the port with other subscribers on this machine.
+	*/
+	UdpServer(std::string address = "localhost", uint16_t port = 9763, DatagramCallback data_recevied_cb = nullptr, std::string capturePath = "", const DatagramFilter& filter = DatagramFilter(), std::string multicastInterface = "");
 	~UdpServer();
 
 	void readMessages();
 	void startThread();
 	void stopThread();
 
+	/*! After a stall, parse only the newest sample of every avatar instead of catching up on all of them.
+		May be switched while the receive thread runs.
+	*/
+	inline void setDrainToLatest(bool enable) { m_drainToLatest = enable; }
+	inline uint64_t staleCount() const { return m_parserManager->staleCount(); }
+
+	// Core and priority of the receive thread, returns what was granted for the log
+	std::string setThreadScheduling(const ThreadScheduling& scheduling);
+
+	// See UdpReceiver::setSpin and UdpReceiver::setBusyPoll
+	inline void setSpin(uint32_t microseconds) { m_receiver->setSpin(microseconds); }
+	inline bool setBusyPoll(uint32_t microseconds) { return m_receiver->setBusyPoll(microseconds); }
+
 private:
-	std::unique_ptr<XsSocket> m_socket;
+	std::unique_ptr<UdpReceiver> m_receiver;
+	DatagramBatch m_batch;
 	uint16_t m_port;
-	XsString m_hostName;
+	std::string m_hostName;
 
 	std::unique_ptr<ParserManager> m_parserManager;
+	std::thread m_thread;
+	PacketCaptureWriter m_capture;
 
 	volatile std::atomic_bool m_started, m_stopping;
+	std::atomic_bool m_drainToLatest;
 
 };
 
@@ -0,0 +1,132 @@
+/*! \file
+	\section FileCopyright Copyright Notice
+	This is free and unencumbered software released into the public domain.
+
+	Anyone is free to copy, modify, publish, use, compile, sell, or
+	distribute this software, either in source code form or as a compiled
+	binary, for any purpose, commercial or non-commercial, and by any
+	means.
+
+	In jurisdictions that recognize copyright laws, the author or authors
+	of this software dedicate any and all copyright interest in the
+	software to the public domain. We make this dedication for the benefit
+	of the public at large and to the detriment of our heirs and
+	successors. We intend this dedication to be an overt act of
+	relinquishment in perpetuity of all present and future rights to this
+	software under copyright law.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+	MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+	IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+	OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+	ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "unity3ddatagram.h"
+
+/*! \class Unity3DDatagram
+  \brief a Position & Quaternion orientation pose datagram for Unity3D (type 05)
+
+  Information about each segment is sent as follows.
+
+  4 bytes segment ID, in the range 1-30
+  4 bytes x-coordinate of sensor position
+  4 bytes y-coordinate of sensor position
+  4 bytes z-coordinate of sensor position
+  4 bytes q1 rotation - sensor rotation quaternion component 1 (re)
+  4 bytes q2 rotation - sensor rotation quaternion component 1 (i)
+  4 bytes q3 rotation - sensor rotation quaternion component 1 (j)
+  4 bytes q4 rotation - sensor rotation quaternion component 1 (k)
+
+  Total: 32 bytes per segment
+
+  The records are those of the quaternion pose datagram, but MVN converts them to the Unity3D
+  coordinate system before sending: Y-Up and left-handed, with x to the right and z forward. A
+  Z-Up position (x, y, z) arrives as (-y, z, x) and a quaternion (re, i, j, k) as (re, j, -k, -i).
+  Unlike the quaternion datagram, the components are left as sent.
+ */
+
+/*! Constructor */
+Unity3DDatagram::Unity3DDatagram()
+	: Datagram()
+	, m_wire(nullptr)
+	, m_wireCount(0)
+{
+	setType(SPPoseUnity3D);
+}
+
+/*! Destructor */
+Unity3DDatagram::~Unity3DDatagram()
+{
+
+}
+
+/*! Gather the record at \a index from the decoded columns */
+Unity3DDatagram::Kinematics Unity3DDatagram::record(size_t index) const
+{
+	Kinematics kin;
+	kin.segmentId = m_records.segmentId[index];
+	for (int k = 0; k < 3; k++)
+		kin.position[k] = m_records.column(1 + k)[index];
+	for (int k = 0; k < 4; k++)
+		kin.orientation[k] = m_records.column(4 + k)[index];
+	return kin;
+}
+
+/*! The record of \a segmentIndex, or one with a segmentId of -1 if the packet did not carry it */
+Unity3DDatagram::Kinematics Unity3DDatagram::GetSegmentData(Segment segmentIndex) const
+{
+	int index = m_records.find(segmentIndex + 1);
+	if (index < 0)
+		return Kinematics{-1};
+	return record(index);
+}
+
+/*! Deserialize the data from \a inputStreamer */
+void Unity3DDatagram::deserializeData(Streamer &inputStreamer)
+{
+	Streamer* streamer = &inputStreamer;
+
+	const uint8_t* records = nullptr;
+	if (!streamer->readBlock(records, dataCount() * m_records.RecordSize)) {
+		m_records.clear();
+		m_wireCount = 0;
+		return;
+	}
+	m_wire = records;
+	m_wireCount = dataCount();
+
+	// A consumer reading the records with forEachRecord does not need the columns
+	if (!decodeRecords()) {
+		m_records.clear();
+		return;
+	}
+	RecordDecoder::decode(records, dataCount(), segmentFilter(), m_records);
+}
+
+/*! Print Data datagram in a formatted way
+*/
+void Unity3DDatagram::printData() const
+{
+	for (size_t i = 0; i < m_records.count; i++)
+	{
+		const Kinematics kin = record(i);
+
+		std::cout << "Segment (ID): " << kin.segmentId << std::endl;
+
+		// Position
+		std::cout << "Segment Position: " << "(";
+		std::cout << "x: " << kin.position[0] << ", ";
+		std::cout << "y: " << kin.position[1] << ", ";
+		std::cout << "z: " << kin.position[2] << ")"<< std::endl;
+
+		// Quaternion Orientation
+		std::cout << "Quaternion Orientation: " << "(";
+		std::cout << "re: " << kin.orientation[0] << ", ";
+		std::cout << "i: " << kin.orientation[1] << ", ";
+		std::cout << "j: " << kin.orientation[2] << ", ";
+		std::cout << "k: " << kin.orientation[3] << ")"<< std::endl << std::endl;
+	}
+}
@@ -0,0 +1,70 @@
+/*! \file
+	\section FileCopyright Copyright Notice
+	This is free and unencumbered software released into the public domain.
+
+	Anyone is free to copy, modify, publish, use, compile, sell, or
+	distribute this software, either in source code form or as a compiled
+	binary, for any purpose, commercial or non-commercial, and by any
+	means.
+
+	In jurisdictions that recognize copyright laws, the author or authors
+	of this software dedicate any and all copyright interest in the
+	software to the public domain. We make this dedication for the benefit
+	of the public at large and to the detriment of our heirs and
+	successors. We intend this dedication to be an overt act of
+	relinquishment in perpetuity of all present and future rights to this
+	software under copyright law.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+	MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+	IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+	OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+	ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef UNITY3DDATAGRAM_H
+#define UNITY3DDATAGRAM_H
+
+#include "datagram.h"
+#include "recorddecoder.h"
+#include "segments.h"
+
+class Unity3DDatagram : public Datagram {
+public:
+	Unity3DDatagram();
+	virtual ~Unity3DDatagram();
+	virtual void printData() const override;
+
+	struct Kinematics {
+		int segmentId;
+		float position[3];		// position relative to global origin, Y-up left-handed
+		float orientation[4];	// orientation (quaternion, re i j k) relative to global space, Y-up left-handed
+	};
+	Kinematics GetSegmentData(Segment segmentIdx) const;
+
+	/*! Call \a sink(segmentId, fields) for the record of every segment in \a wanted, read straight
+		from the packet. The fields are position x y z and orientation re i j k. Only valid inside
+		the datagram callback, while the packet is, see Datagram::setDecodeRecords.
+	*/
+	template<typename Sink>
+	inline size_t forEachRecord(const SegmentIdMask& wanted, Sink&& sink) const
+	{
+		return RecordDecoder::forEachRecord<8>(m_wire, m_wireCount, wanted, sink);
+	}
+
+protected:
+	virtual void deserializeData(Streamer &inputStreamer) override;
+
+private:
+	Kinematics record(size_t index) const;
+
+	RecordColumns<8, MaxDataCount> m_records;
+
+	// The records in the packet being handled, see forEachRecord
+	const uint8_t* m_wire;
+	size_t m_wireCount;
+};
+
+#endif